@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <thread>
+
+#include "ecsify/component.h"
+#include "ecsify/internal/numa.h"
+#include "ecsify/sharded_world.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Payload : ecsify::ComponentMixin<1> {
+  std::array<std::uint64_t, 8> data;
+};
+
+void Populate(ecsify::World &world, std::int64_t count) {
+  for (std::int64_t idx = 0; idx < count; ++idx) {
+    world.Add<Payload>(world.Add());
+  }
+}
+
+void Iterate(benchmark::State &state, ecsify::ShardedWorld &shards) {
+  for (auto _ : state) {
+    shards.Run([](ecsify::World &world) {
+      for (auto [payload] : world.Query<Payload>()) {
+        benchmark::DoNotOptimize(payload.data[0] += 1);
+      }
+    });
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(Payload));
+}
+
+// The shard is populated by its own worker, so its storage is on the node
+// the worker is pinned to.
+void BM_IterateLocalShard(benchmark::State &state) {
+  auto shards = ecsify::WorldBuilder{}.Component<Payload>().BuildShards(
+      1, ecsify::Placement::kNuma);
+  shards->Run([&](ecsify::World &world) { Populate(world, state.range(0)); });
+  Iterate(state, *shards);
+}
+BENCHMARK(BM_IterateLocalShard)->Arg(1 << 20)->UseRealTime();
+
+// The shard is populated from the last node and processed on the first one.
+// Matches the local benchmark on machines with a single node.
+void BM_IterateRemoteShard(benchmark::State &state) {
+  auto shards = ecsify::WorldBuilder{}.Component<Payload>().BuildShards(
+      1, ecsify::Placement::kNuma);
+  std::thread populate([&] {
+    ecsify::internal::BindThreadToNode(ecsify::internal::NumaNodes().back());
+    Populate((*shards)[0], state.range(0));
+  });
+  populate.join();
+  Iterate(state, *shards);
+}
+BENCHMARK(BM_IterateRemoteShard)->Arg(1 << 20)->UseRealTime();
+
+}  // namespace
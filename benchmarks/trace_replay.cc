@@ -0,0 +1,241 @@
+// Plays back a trace recorded with WorldBuilder::RecordTrace against the
+// current build and reports the throughput and the latency percentiles of
+// every operation.
+//
+// Usage: ecsify_trace_replay <trace>
+//
+// Component types are replaced by blobs of kBlobSize bytes, so the replayed
+// world has the shape of the recorded one but not its component sizes.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/internal/replay_access.h"
+#include "ecsify/query.h"
+#include "ecsify/trace.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+constexpr std::size_t kBlobSize = 64;
+constexpr std::size_t kNumBlobs = 31;
+
+template <std::size_t kTypeID>
+struct Blob : ecsify::ComponentMixin<kTypeID> {
+  std::array<std::uint8_t, kBlobSize> data{};
+};
+
+template <std::size_t... kIdx>
+std::unique_ptr<ecsify::World> BuildWorld(std::index_sequence<kIdx...>) {
+  return ecsify::WorldBuilder<Blob<kIdx + 1>...>{}.Build();
+}
+
+// Reads every row of the storages.
+template <class T>
+std::size_t Touch(std::span<void *const> columns) {
+  std::size_t sum = 0;
+  for (auto [component] : ecsify::QueryView<T>{{columns}}) {
+    if constexpr (std::is_same_v<T, ecsify::Entity>) {
+      sum += component.handle();
+    } else {
+      sum += component.data[0];
+    }
+  }
+  return sum;
+}
+
+using TouchFunction = std::size_t (*)(std::span<void *const>);
+
+template <std::size_t... kIdx>
+constexpr std::array<TouchFunction, 1 + kNumBlobs> MakeTouchTable(
+    std::index_sequence<kIdx...>) {
+  return {&Touch<ecsify::Entity>, &Touch<Blob<kIdx + 1>>...};
+}
+
+constexpr std::array<TouchFunction, 1 + kNumBlobs> kTouch =
+    MakeTouchTable(std::make_index_sequence<kNumBlobs>{});
+
+constexpr std::array<const char *, ecsify::kNumTraceOps> kOpNames = {
+    "AddEntity",       "RemoveEntity", "AddComponent",
+    "RemoveComponent", "GetComponent", "Query"};
+
+using ecsify::internal::ReplayAccess;
+
+class TraceReplayer final {
+ public:
+  explicit TraceReplayer(ecsify::World &world) : world_{world} {}
+
+  // Returns false if the record refers to an entity which wasn't recorded as
+  // added, e.g. one created by Instantiate. Throws std::runtime_error if it
+  // refers to a component type or an entity handle the world can't have.
+  bool Replay(const ecsify::TraceRecord &record) {
+    Validate(record);
+    if (record.op != ecsify::TraceOp::kQuery &&
+        record.op != ecsify::TraceOp::kAddEntity &&
+        (record.entity >= entities_.size() ||
+         !world_.Alive(entities_[record.entity]))) {
+      return false;
+    }
+    switch (record.op) {
+      case ecsify::TraceOp::kAddEntity:
+        if (entities_.size() <= record.entity) {
+          entities_.resize(record.entity + 1);
+        }
+        entities_[record.entity] = world_.Add();
+        break;
+      case ecsify::TraceOp::kRemoveEntity:
+        world_.Remove(entities_[record.entity]);
+        break;
+      case ecsify::TraceOp::kAddComponent:
+        ReplayAccess::Add(world_, entities_[record.entity], record.component);
+        break;
+      case ecsify::TraceOp::kRemoveComponent:
+        ReplayAccess::Remove(world_, entities_[record.entity],
+                             record.component);
+        break;
+      case ecsify::TraceOp::kGetComponent:
+        if (!ReplayAccess::Has(world_, entities_[record.entity],
+                               record.component)) {
+          return false;
+        }
+        sink_ += reinterpret_cast<const std::uint8_t &>(
+            ReplayAccess::Get(world_, entities_[record.entity],
+                              record.component));
+        break;
+      case ecsify::TraceOp::kQuery:
+        query_.assign(record.components.begin(), record.components.end());
+        for (std::size_t component_type : query_) {
+          sink_ += kTouch[component_type](
+              ReplayAccess::Query(world_, component_type, query_));
+        }
+        break;
+    }
+    return true;
+  }
+
+  // Keeps the reads from being optimized out.
+  std::size_t sink() const noexcept { return sink_; }
+
+ private:
+  // Entity handles are below the generation step of the entity ids.
+  static constexpr std::size_t kMaxHandle = std::size_t{1} << 32;
+
+  static void Validate(const ecsify::TraceRecord &record) {
+    if (record.entity >= kMaxHandle) {
+      throw std::runtime_error("Entity handle out of range in trace");
+    }
+    auto valid = [](std::size_t component_type) {
+      return component_type < kTouch.size();
+    };
+    switch (record.op) {
+      case ecsify::TraceOp::kAddComponent:
+      case ecsify::TraceOp::kRemoveComponent:
+      case ecsify::TraceOp::kGetComponent:
+        if (!valid(record.component)) {
+          throw std::runtime_error("Unknown component type in trace");
+        }
+        break;
+      case ecsify::TraceOp::kQuery:
+        if (!std::ranges::all_of(record.components, valid)) {
+          throw std::runtime_error("Unknown component type in trace");
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  ecsify::World &world_;
+  // Replayed entities by recorded handles.
+  std::vector<ecsify::Entity> entities_;
+  std::vector<std::size_t> query_;
+  std::size_t sink_{0};
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "Usage: %s <trace>\n", argv[0]);
+    return 2;
+  }
+  try {
+    ecsify::TraceReader reader{argv[1]};
+    if (reader.component_sizes().size() > 1 + kNumBlobs) {
+      std::fprintf(stderr, "The trace has %zu component types, at most %zu "
+                   "are supported\n",
+                   reader.component_sizes().size(), 1 + kNumBlobs);
+      return 1;
+    }
+    std::unique_ptr<ecsify::World> world =
+        BuildWorld(std::make_index_sequence<kNumBlobs>{});
+    TraceReplayer replayer{*world};
+
+    using Clock = std::chrono::steady_clock;
+    std::array<std::vector<std::int64_t>, ecsify::kNumTraceOps> latencies;
+    std::size_t skipped = 0;
+    Clock::duration total{};
+    ecsify::TraceRecord record;
+    while (reader.Next(record)) {
+      auto start = Clock::now();
+      bool replayed = replayer.Replay(record);
+      auto elapsed = Clock::now() - start;
+      if (!replayed) {
+        ++skipped;
+        continue;
+      }
+      total += elapsed;
+      latencies[static_cast<std::size_t>(record.op)].push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count());
+    }
+
+    std::size_t num_ops = 0;
+    std::printf("%-16s %10s %10s %10s %10s %10s %10s\n", "op", "count",
+                "mean ns", "p50 ns", "p90 ns", "p99 ns", "max ns");
+    for (std::size_t op = 0; op < ecsify::kNumTraceOps; ++op) {
+      std::vector<std::int64_t> &samples = latencies[op];
+      if (samples.empty()) {
+        continue;
+      }
+      num_ops += samples.size();
+      std::ranges::sort(samples);
+      auto percentile = [&](std::size_t pct) {
+        return samples[(samples.size() - 1) * pct / 100];
+      };
+      std::int64_t sum = 0;
+      for (std::int64_t sample : samples) {
+        sum += sample;
+      }
+      std::printf("%-16s %10zu %10lld %10lld %10lld %10lld %10lld\n",
+                  kOpNames[op], samples.size(),
+                  static_cast<long long>(sum / std::ssize(samples)),
+                  static_cast<long long>(percentile(50)),
+                  static_cast<long long>(percentile(90)),
+                  static_cast<long long>(percentile(99)),
+                  static_cast<long long>(samples.back()));
+    }
+    double seconds = std::chrono::duration<double>(total).count();
+    std::printf("\n%zu ops in %.3f s, %.0f ops/s, %zu skipped (checksum %zu)\n",
+                num_ops, seconds, seconds > 0 ? num_ops / seconds : 0.0,
+                skipped, replayer.sink());
+  } catch (const std::exception &error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_COMPONENT_OBSERVER_H_
+#define ECSIFY_INCLUDE_ECSIFY_COMPONENT_OBSERVER_H_
+
+#include <span>
+
+#include "ecsify/entity.h"
+
+namespace ecsify {
+
+class World;
+
+namespace internal {
+
+struct ComponentObserverBase {
+  virtual ~ComponentObserverBase() = default;
+
+  virtual void NotifyAdd(World &world, std::span<const Entity> entities) = 0;
+  virtual void NotifySet(World &world, std::span<const Entity> entities) = 0;
+  virtual void NotifyRemove(World &world,
+                            std::span<const Entity> entities) = 0;
+};
+
+}  // namespace internal
+
+// Receives changes of the component in batches. Unlike ComponentTracker, the
+// changes are recorded and delivered by World::Notify, one batch per run of
+// entities making the same archetype transition. By then the entities may be
+// dead or lack the component, so check World::Has before reading it. Only
+// writes made through World::Set or reported by World::Modified are observed.
+template <class Component>
+class ComponentObserver : public internal::ComponentObserverBase {
+ public:
+  virtual void OnAdd(World &world, std::span<const Entity> entities) = 0;
+  virtual void OnSet(World &world, std::span<const Entity> entities) = 0;
+  virtual void OnRemove(World &world, std::span<const Entity> entities) = 0;
+
+ private:
+  void NotifyAdd(World &world, std::span<const Entity> entities) final {
+    OnAdd(world, entities);
+  }
+
+  void NotifySet(World &world, std::span<const Entity> entities) final {
+    OnSet(world, entities);
+  }
+
+  void NotifyRemove(World &world, std::span<const Entity> entities) final {
+    OnRemove(world, entities);
+  }
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_COMPONENT_OBSERVER_H_
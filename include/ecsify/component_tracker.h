@@ -0,0 +1,48 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_COMPONENT_TRACKER_H_
+#define ECSIFY_INCLUDE_ECSIFY_COMPONENT_TRACKER_H_
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+
+namespace ecsify {
+
+namespace internal {
+
+struct ComponentTrackerBase {
+  virtual ~ComponentTrackerBase() = default;
+
+  virtual void NotifyAdd(Entity entity, const ComponentBase &component) = 0;
+  virtual void NotifySet(Entity entity, const ComponentBase &component) = 0;
+  virtual void NotifyRemove(Entity entity) = 0;
+};
+
+}  // namespace internal
+
+// Receives changes of the component synchronously. Register trackers with
+// WorldBuilder::Track to keep external structures (e.g. indices) up to date.
+// Only writes made through World::Set or reported by World::Modified are
+// tracked.
+template <class Component>
+class ComponentTracker : public internal::ComponentTrackerBase {
+ public:
+  virtual void OnAdd(Entity entity, const Component &component) = 0;
+  virtual void OnSet(Entity entity, const Component &component) = 0;
+  virtual void OnRemove(Entity entity) = 0;
+
+ private:
+  void NotifyAdd(Entity entity,
+                 const internal::ComponentBase &component) final {
+    OnAdd(entity, static_cast<const Component &>(component));
+  }
+
+  void NotifySet(Entity entity,
+                 const internal::ComponentBase &component) final {
+    OnSet(entity, static_cast<const Component &>(component));
+  }
+
+  void NotifyRemove(Entity entity) final { OnRemove(entity); }
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_COMPONENT_TRACKER_H_
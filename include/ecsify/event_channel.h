@@ -0,0 +1,110 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_EVENT_CHANNEL_H_
+#define ECSIFY_INCLUDE_ECSIFY_EVENT_CHANNEL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ecsify {
+
+namespace internal {
+
+struct EventChannelBase {
+  virtual ~EventChannelBase() = default;
+
+  // Publish the events written since the previous call.
+  virtual void Swap() = 0;
+};
+
+using EventChannelRef = std::unique_ptr<EventChannelBase>;
+
+// Dense ids of the threads which ever wrote an event.
+inline std::size_t ThreadSlot() noexcept {
+  static std::atomic<std::size_t> next_slot{0};
+  thread_local std::size_t slot =
+      next_slot.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+inline std::size_t NextEventTypeID() noexcept {
+  static std::atomic<std::size_t> next_id{0};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Event types are plain structs, so their ids are assigned on first use.
+template <class Event>
+std::size_t EventTypeID() noexcept {
+  static const std::size_t id = NextEventTypeID();
+  return id;
+}
+
+}  // namespace internal
+
+/**
+ * @brief Typed events passed between systems, registered with
+ * WorldBuilder::Event.
+ *
+ * Events written during a tick are read during the next one: World::Update
+ * swaps the buffers before running the systems. Writers append to per-thread
+ * segments, readers see the events of the previous tick as one contiguous
+ * span. Buffers keep their memory, so the steady state allocates nothing.
+ */
+template <class Event>
+class EventChannel final : public internal::EventChannelBase {
+ public:
+  // Thread-safe. Threads don't contend unless there are more writers than
+  // segments.
+  void Write(Event event) {
+    Segment &segment = segments_[internal::ThreadSlot() % kNumSegments];
+    Lock(segment);
+    segment.events.push_back(std::move(event));
+    Unlock(segment);
+  }
+
+  // Events written before the last swap in the order of the writer threads.
+  // Must not be called concurrently with Swap.
+  std::span<const Event> Read() const noexcept { return read_; }
+
+  void Swap() override {
+    read_.clear();
+    for (Segment &segment : segments_) {
+      Lock(segment);
+      read_.insert(read_.end(), std::make_move_iterator(segment.events.begin()),
+                   std::make_move_iterator(segment.events.end()));
+      segment.events.clear();
+      Unlock(segment);
+    }
+  }
+
+ private:
+  static constexpr std::size_t kNumSegments = 64;
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Segment {
+    std::atomic_flag busy;
+    std::vector<Event> events;
+  };
+
+  static void Lock(Segment &segment) noexcept {
+    while (segment.busy.test_and_set(std::memory_order_acquire)) {
+      while (segment.busy.test(std::memory_order_relaxed)) {
+      }
+    }
+  }
+
+  static void Unlock(Segment &segment) noexcept {
+    segment.busy.clear(std::memory_order_release);
+  }
+
+  std::array<Segment, kNumSegments> segments_{};
+  std::vector<Event> read_;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_EVENT_CHANNEL_H_
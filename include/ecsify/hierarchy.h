@@ -0,0 +1,26 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_HIERARCHY_H_
+#define ECSIFY_INCLUDE_ECSIFY_HIERARCHY_H_
+
+#include <cstddef>
+#include <limits>
+
+#include "ecsify/entity.h"
+
+namespace ecsify {
+
+// An entry of the breadth-first hierarchy traversal. Parents always precede
+// their children, so values derived from the parent (e.g. world transforms)
+// can be computed in a single linear sweep over an array indexed the same way
+// as the traversal.
+struct HierarchyNode {
+  static constexpr std::size_t kNoParent =
+      std::numeric_limits<std::size_t>::max();
+
+  Entity entity;
+  // Index of the parent node in the traversal or kNoParent for roots.
+  std::size_t parent;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_HIERARCHY_H_
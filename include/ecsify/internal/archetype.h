@@ -2,6 +2,7 @@
 #define ECSIFY_INCLUDE_ECSIFY_INTERNAL_ARCHETYPE_H_
 
 #include <array>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -9,6 +10,7 @@
 #include <iterator>
 #include <limits>
 #include <ranges>
+#include <vector>
 
 namespace ecsify::internal {
 
@@ -114,16 +116,18 @@ class Archetype {
   }
 
   std::size_t Hash() const noexcept {
-    std::size_t result = 0;
+    std::uint64_t result = 0;
     for (std::uint64_t val : data_) {
-      result ^= val;
+      // Mix every word, so that signatures differing in several words don't
+      // cancel out like they do with plain XOR.
+      result = Mix(result ^ val);
     }
-    return result;
+    return static_cast<std::size_t>(result);
   }
 
   bool IsPrefix(const Archetype<Bits> &other) const noexcept {
     for (auto [val, other_val] : std::views::zip(data_, other.data_)) {
-      if (val & other_val != val) {
+      if ((val & other_val) != val) {
         return false;
       }
     }
@@ -132,6 +136,18 @@ class Archetype {
 
   std::size_t Size() const noexcept { return Bits; }
 
+  // Returns the set bits in increasing order.
+  std::vector<std::size_t> Ones() const {
+    std::vector<std::size_t> result;
+    for (std::size_t idx = 0; idx < data_.size(); ++idx) {
+      for (std::uint64_t val = data_[idx]; val != 0; val &= val - 1) {
+        result.push_back(idx * std::numeric_limits<std::uint64_t>::digits +
+                         std::countr_zero(val));
+      }
+    }
+    return result;
+  }
+
   ArchetypeIterator<Bits> begin() { return ArchetypeIterator(this, 0); }
   ArchetypeIterator<Bits> end() { return ArchetypeIterator(this, Bits); }
 
@@ -152,7 +168,14 @@ class Archetype {
 
   static constexpr std::uint64_t OffsetMask(std::size_t bit) {
     std::size_t offset = bit % std::numeric_limits<std::uint64_t>::digits;
-    return static_cast<std::uint64_t>(1 << offset);
+    return static_cast<std::uint64_t>(1) << offset;
+  }
+
+  // The splitmix64 finalizer.
+  static constexpr std::uint64_t Mix(std::uint64_t val) {
+    val = (val ^ (val >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    val = (val ^ (val >> 27)) * 0x94d049bb133111ebULL;
+    return val ^ (val >> 31);
   }
 
   static consteval std::size_t UnderlyingCapacity(std::size_t bits) {
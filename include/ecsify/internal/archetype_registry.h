@@ -0,0 +1,215 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_ARCHETYPE_REGISTRY_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_ARCHETYPE_REGISTRY_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ecsify/internal/archetype.h"
+
+namespace ecsify::internal {
+
+// Interns archetype signatures into dense ids, so that entities and pools
+// refer to an archetype by a single integer. Ids are never reused and follow
+// the registration order. Prefab archetypes and archetypes of regions have the
+// same signatures as regular ones but get ids of their own, see
+// World::AddPrefab and World::AddRegion. So do archetypes differing only by
+// the values of their shared components, see WorldBuilder::Shared.
+template <std::size_t N>
+class ArchetypeRegistry final {
+ public:
+  // Id of the archetype without components.
+  static constexpr std::size_t kEmpty = 0;
+  static constexpr std::size_t kEmptyPrefab = 1;
+
+  // Shared component types of an archetype in increasing order and the ids
+  // of their values, see SharedPool.
+  using SharedValues = std::vector<std::pair<std::size_t, std::size_t>>;
+
+  struct Record {
+    Archetype<N> signature;
+    // Component types stored in columns in increasing order, so the shared
+    // ones are left out.
+    std::vector<std::size_t> components;
+    SharedValues shared;
+    bool prefab;
+    // Id of the region or zero for the rest of the world.
+    std::size_t region;
+    // Archetypes reached by adding or removing a component, filled lazily.
+    std::unordered_map<std::size_t, std::size_t> add_edges;
+    std::unordered_map<std::size_t, std::size_t> remove_edges;
+  };
+
+  ArchetypeRegistry() {
+    Intern(Archetype<N>{});
+    Intern(Archetype<N>{}, true);
+  }
+
+  // Store the component once per value instead of in a column. Must be
+  // called before registering archetypes with components.
+  void MarkShared(std::size_t component_type) {
+    assert(records_.size() == 2 && "Archetypes are already registered");
+    shared_.Set(component_type);
+  }
+
+  // Returns the id of the archetype registering it if needed. Shared values
+  // are given for every shared component of the signature.
+  std::size_t Intern(const Archetype<N> &signature, bool prefab = false,
+                     std::size_t region = 0, SharedValues shared = {}) {
+    assert((!prefab || region == 0) && "Prefabs don't belong to regions");
+    if (partitions_.size() <= region) {
+      partitions_.resize(region + 1);
+    }
+    Partition &partition = partitions_[region];
+    auto [it, inserted] = partition.ids[prefab].try_emplace(
+        Key{.signature = signature, .shared = shared}, records_.size());
+    if (inserted) {
+      std::vector<std::size_t> components;
+      for (std::size_t component_type : signature.Ones()) {
+        if (!shared_.At(component_type)) {
+          components.push_back(component_type);
+        }
+      }
+      partition.archetypes.push_back(records_.size());
+      records_.push_back(Record{.signature = signature,
+                                .components = std::move(components),
+                                .shared = std::move(shared),
+                                .prefab = prefab,
+                                .region = region});
+    }
+    return it->second;
+  }
+
+  // Returns the archetype with the shared component set to the value.
+  std::size_t Share(std::size_t archetype, std::size_t component_type,
+                    std::size_t value) {
+    assert(shared_.At(component_type) && "Component isn't shared");
+    const Record &record = records_[archetype];
+    Archetype<N> signature = record.signature;
+    signature.Set(component_type);
+    SharedValues shared = record.shared;
+    auto it = std::ranges::lower_bound(shared, component_type,
+                                       {}, &SharedValues::value_type::first);
+    if (it != shared.end() && it->first == component_type) {
+      if (it->second == value) {
+        return archetype;
+      }
+      it->second = value;
+    } else {
+      shared.emplace(it, component_type, value);
+    }
+    return Intern(signature, record.prefab, record.region, std::move(shared));
+  }
+
+  // Returns the id of the value of the shared component of the archetype.
+  std::size_t SharedValue(std::size_t archetype,
+                          std::size_t component_type) const {
+    const SharedValues &shared = records_[archetype].shared;
+    auto it = std::ranges::lower_bound(shared, component_type,
+                                       {}, &SharedValues::value_type::first);
+    assert(it != shared.end() && it->first == component_type &&
+           "Archetype lacks the shared component");
+    return it->second;
+  }
+
+  // Returns the archetypes of the region in registration order.
+  std::span<const std::size_t> Region(std::size_t region) const {
+    if (region >= partitions_.size()) {
+      return {};
+    }
+    return partitions_[region].archetypes;
+  }
+
+  // Returns the archetype with the component added.
+  std::size_t With(std::size_t archetype, std::size_t component_type) {
+    return Follow(archetype, component_type, &Record::add_edges, true);
+  }
+
+  // Returns the archetype with the component removed.
+  std::size_t Without(std::size_t archetype, std::size_t component_type) {
+    return Follow(archetype, component_type, &Record::remove_edges, false);
+  }
+
+  bool Has(std::size_t archetype, std::size_t component_type) const {
+    return records_[archetype].signature.At(component_type);
+  }
+
+  // References are invalidated by registering new archetypes.
+  const Record &operator[](std::size_t archetype) const {
+    assert(archetype < records_.size() && "Unknown archetype");
+    return records_[archetype];
+  }
+
+  std::size_t Size() const noexcept { return records_.size(); }
+
+ private:
+  using Edges = std::unordered_map<std::size_t, std::size_t>;
+
+  std::size_t Follow(std::size_t archetype, std::size_t component_type,
+                     Edges Record::*edges, bool link) {
+    auto it = (records_[archetype].*edges).find(component_type);
+    if (it != (records_[archetype].*edges).end()) {
+      return it->second;
+    }
+    Archetype<N> signature = records_[archetype].signature;
+    SharedValues shared = records_[archetype].shared;
+    auto value = std::ranges::lower_bound(
+        shared, component_type, {}, &SharedValues::value_type::first);
+    bool present = value != shared.end() && value->first == component_type;
+    if (link) {
+      signature.Set(component_type);
+      // Added shared components take the default value.
+      if (shared_.At(component_type) && !present) {
+        shared.emplace(value, component_type, 0);
+      }
+    } else {
+      signature.Unset(component_type);
+      if (present) {
+        shared.erase(value);
+      }
+    }
+    std::size_t result = Intern(signature, records_[archetype].prefab,
+                                records_[archetype].region, std::move(shared));
+    (records_[archetype].*edges).emplace(component_type, result);
+    return result;
+  }
+
+  struct Key {
+    Archetype<N> signature;
+    SharedValues shared;
+
+    friend bool operator==(const Key &lhs, const Key &rhs) = default;
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const noexcept {
+      std::size_t result = key.signature.Hash();
+      for (auto [component_type, value] : key.shared) {
+        result ^= value + 0x9e3779b97f4a7c15ULL + (result << 6) + (result >> 2);
+      }
+      return result;
+    }
+  };
+
+  // Archetypes of a region or of the rest of the world.
+  struct Partition {
+    // Regular and prefab archetypes.
+    std::array<std::unordered_map<Key, std::size_t, KeyHash>, 2> ids;
+    std::vector<std::size_t> archetypes;
+  };
+
+  std::vector<Record> records_;
+  // Types of the shared components.
+  Archetype<N> shared_;
+  // Indexed by region ids.
+  std::vector<Partition> partitions_;
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_ARCHETYPE_REGISTRY_H_
@@ -0,0 +1,68 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_CHANGE_LOG_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_CHANGE_LOG_H_
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "ecsify/entity.h"
+
+namespace ecsify::internal {
+
+enum class Change { kAdd, kSet, kRemove };
+
+// Changes of one component type in the order they were made. Consecutive
+// changes of the same kind and archetype transition share a batch. Clearing
+// keeps the memory, so a steady state allocates nothing.
+class ChangeLog final {
+ public:
+  // Archetype of created or destroyed entities.
+  static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+  void Record(Change change, std::size_t from, std::size_t to, Entity entity) {
+    if (batches_.empty() || batches_.back().change != change ||
+        batches_.back().from != from || batches_.back().to != to) {
+      batches_.push_back(Batch{.change = change,
+                               .from = from,
+                               .to = to,
+                               .begin = entities_.size()});
+    }
+    entities_.push_back(entity);
+  }
+
+  // Calls visitor(change, entities) for every batch.
+  template <class Visitor>
+  void Visit(Visitor &&visitor) const {
+    for (std::size_t idx = 0; idx < batches_.size(); ++idx) {
+      std::size_t end = idx + 1 < batches_.size() ? batches_[idx + 1].begin
+                                                  : entities_.size();
+      visitor(batches_[idx].change,
+              std::span<const Entity>{entities_.begin() + batches_[idx].begin,
+                                      entities_.begin() + end});
+    }
+  }
+
+  bool Empty() const noexcept { return batches_.empty(); }
+
+  void Clear() noexcept {
+    batches_.clear();
+    entities_.clear();
+  }
+
+ private:
+  struct Batch {
+    Change change;
+    std::size_t from;
+    std::size_t to;
+    // Index of the first entity of the batch.
+    std::size_t begin;
+  };
+
+  std::vector<Batch> batches_;
+  std::vector<Entity> entities_;
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_CHANGE_LOG_H_
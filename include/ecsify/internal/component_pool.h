@@ -1,90 +1,440 @@
 #ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_COMPONENT_POOL_H_
 #define ECSIFY_INCLUDE_ECSIFY_INTERNAL_COMPONENT_POOL_H_
 
+#include <algorithm>
+#include <cassert>
+#include <charconv>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
 #include <memory>
+#include <optional>
+#include <ostream>
+#include <ranges>
 #include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "ecsify/component.h"
-#include "ecsify/internal/archetype.h"
 #include "ecsify/internal/data_pool.h"
+#include "ecsify/internal/fork_clock.h"
+#include "ecsify/internal/mapped_file.h"
+#include "ecsify/region.h"
 
 namespace ecsify::internal {
 
-template <std::size_t N>
+using ComponentLess =
+    std::function<bool(const ComponentBase &, const ComponentBase &)>;
+
+template <class T>
+struct RegionColumn final : RegionColumnBase {
+  DataPool<T> rows;
+};
+
+// Stores components of one type in a DataPool per archetype. Archetypes are
+// referred to by their ids in the ArchetypeRegistry of the world.
 struct ComponentPoolBase {
   virtual ~ComponentPoolBase() = default;
 
-  virtual const ComponentBase &Get(const Archetype<N> &archetype,
+  virtual const ComponentBase &Get(std::size_t archetype,
                                    std::size_t handle) const = 0;
-  virtual ComponentBase &Get(const Archetype<N> &archetype,
-                             std::size_t handle) = 0;
-  virtual std::size_t Add(const Archetype<N> &archetype) = 0;
-  virtual void Remove(const Archetype<N> &old_archetype,
-                      std::size_t handle) = 0;
-  virtual std::size_t Move(const Archetype<N> &old_archetype,
-                           std::size_t handle,
-                           const Archetype<N> &new_archetype) = 0;
-  virtual std::span<ComponentBase *> Query(const Archetype<N> &archetype) = 0;
+  virtual ComponentBase &Get(std::size_t archetype, std::size_t handle) = 0;
+  virtual std::size_t Add(std::size_t archetype) = 0;
+  // Add a copy of the component stored in another pool of the same type.
+  virtual std::size_t Add(std::size_t archetype,
+                          const ComponentBase &value) = 0;
+  // Add count copies of the component stored in another pool of the same
+  // type. Rows are taken in the same order as by the other Add overloads.
+  virtual void Fill(std::size_t archetype, const ComponentBase &value,
+                    std::size_t count) = 0;
+  // Add count default constructed components taking slots like Add.
+  virtual void Fill(std::size_t archetype, std::size_t count) = 0;
+  virtual void Remove(std::size_t archetype, std::size_t handle) = 0;
+  // Moved components stay disabled, see SetEnabled.
+  virtual std::size_t Move(std::size_t old_archetype, std::size_t handle,
+                           std::size_t new_archetype) = 0;
+  // Drops every component stored for the archetype at once.
+  virtual void Clear(std::size_t archetype) = 0;
+  // Move all the components of the old archetype to the new one. If swap is
+  // set, the storages are swapped, so the new one must be empty and the
+  // components keep their handles. Otherwise the components are moved in the
+  // iteration order and their new handles are appended to handles if it isn't
+  // null.
+  virtual void MoveAll(std::size_t old_archetype, std::size_t new_archetype,
+                       bool swap, std::vector<std::size_t> *handles) = 0;
+  // Move the rows with the handles to the archetype of another pool of the
+  // same type. Rows are taken at once like by Fill, so every column of the
+  // new archetype gets the same handles, which are appended to new_handles if
+  // it isn't null. Disabled components stay disabled.
+  virtual void MoveRows(std::size_t old_archetype,
+                        std::span<const std::size_t> handles,
+                        ComponentPoolBase &destination,
+                        std::size_t new_archetype,
+                        std::vector<std::size_t> *new_handles) = 0;
+  // Disabled components are kept but skipped by queries, see
+  // DataPool::SetEnabled.
+  virtual void SetEnabled(std::size_t archetype, std::size_t handle,
+                          bool enabled) = 0;
+  virtual bool Enabled(std::size_t archetype, std::size_t handle) const = 0;
+  virtual bool Contains(std::size_t archetype, std::size_t handle) const = 0;
+  // Write the size of the component followed by the bytes of the archetype
+  // rows in the iteration order. Throws std::runtime_error unless the
+  // component is trivially copyable.
+  virtual void Save(std::size_t archetype, std::ostream &out) const = 0;
+  // Read count rows written by Save into a column of their own. Doesn't touch
+  // the pool, so it's safe to call from any thread.
+  virtual RegionColumnRef Load(std::istream &in, std::size_t count) const = 0;
+  // Move the rows of a column returned by Load to the archetype, which must be
+  // empty. The rows take handles from the start.
+  virtual void Adopt(std::size_t archetype, RegionColumnBase &column) = 0;
+  // Returns handles of the archetype rows stably sorted with the comparator.
+  virtual std::vector<std::size_t> Sort(std::size_t archetype,
+                                        const ComponentLess &less) const = 0;
+  // Reorders the archetype rows, see DataPool::Permute.
+  virtual void Permute(std::size_t archetype,
+                       std::span<const std::size_t> handles) = 0;
+  // Returns the DataPool<T> storing the archetype components. The pointer
+  // stays valid for the lifetime of the pool.
+  virtual void *Column(std::size_t archetype) = 0;
+  // Store the archetypes created afterwards in files in the directory named
+  // after the archetype ids. Returns false if the components can't be stored
+  // in files, which leaves them on the heap.
+  virtual bool MapTo(const std::filesystem::path &directory) = 0;
+  // Open the files of the archetypes below num_archetypes keeping their rows
+  // and remove the files of the others. Must be called after MapTo before
+  // storing anything.
+  virtual void Reopen(std::size_t num_archetypes) = 0;
+  // Write the components stored in files to the files.
+  virtual void Sync() = 0;
+  // Journal the changes of every archetype after the forks of the clock, see
+  // DataPool::Journal. Must be called before storing anything.
+  virtual void Journal(const ForkClock *clock) = 0;
+  // Restore the components of every archetype as of the fork.
+  virtual void Rollback(std::uint64_t fork) = 0;
+  // Stamp the buckets of every archetype with the tick of their last change,
+  // see DataPool::TrackWrites. Must be called before storing anything.
+  virtual void TrackWrites(const std::uint64_t *tick) = 0;
 };
 
-template <std::size_t N>
-using ComponentPoolRef = std::unique_ptr<ComponentPoolBase<N>>;
+using ComponentPoolRef = std::unique_ptr<ComponentPoolBase>;
 
-template <class T, std::size_t N>
-class ComponentPool final : public ComponentPoolBase<N> {
+template <class T>
+class ComponentPool final : public ComponentPoolBase {
  public:
-  T &Get(const Archetype<N> &archetype, std::size_t handle) override {
-    return components_[archetype][handle];
+  T &Get(std::size_t archetype, std::size_t handle) override {
+    return Storage(archetype)[handle];
   }
 
-  const T &Get(const Archetype<N> &archetype,
-               std::size_t handle) const override {
+  const T &Get(std::size_t archetype, std::size_t handle) const override {
     return components_.at(archetype)[handle];
   }
 
-  std::size_t Add(const Archetype<N> &archetype) override {
-    query_cache_.clear();
-    return components_[archetype].Insert();
+  std::size_t Add(std::size_t archetype) override {
+    return Storage(archetype).Insert();
   }
 
-  void Remove(const Archetype<N> &archetype, std::size_t handle) override {
-    if (!components_.contains(archetype)) {
-      return;
+  std::size_t Add(std::size_t archetype, const ComponentBase &value) override {
+    DataPool<T> &pool = Storage(archetype);
+    std::size_t handle = pool.Insert();
+    pool[handle] = static_cast<const T &>(value);
+    return handle;
+  }
+
+  void Fill(std::size_t archetype, const ComponentBase &value,
+            std::size_t count) override {
+    Storage(archetype).Fill(static_cast<const T &>(value), count);
+  }
+
+  void Fill(std::size_t archetype, std::size_t count) override {
+    Storage(archetype).Fill(T{}, count);
+  }
+
+  void Remove(std::size_t archetype, std::size_t handle) override {
+    auto it = components_.find(archetype);
+    if (it != components_.end()) {
+      it->second.Erase(handle);
     }
-    components_[archetype].Erase(handle);
-    query_cache_.clear();
   }
 
-  std::size_t Move(const Archetype<N> &old_archetype, std::size_t handle,
-                   const Archetype<N> &new_archetype) override {
-    T tmp = std::move(components_[old_archetype][handle]);
-    std::size_t new_handle = components_[new_archetype].Insert();
-    components_[new_archetype][new_handle] = std::move(tmp);
-    query_cache_.clear();
+  std::size_t Move(std::size_t old_archetype, std::size_t handle,
+                   std::size_t new_archetype) override {
+    DataPool<T> &old_pool = Storage(old_archetype);
+    DataPool<T> &new_pool = Storage(new_archetype);
+    std::size_t new_handle = new_pool.Insert();
+    new_pool[new_handle] = std::move(old_pool[handle]);
+    if (!old_pool.Enabled(handle)) {
+      new_pool.SetEnabled(new_handle, false);
+    }
+    old_pool.Erase(handle);
     return new_handle;
   }
 
-  std::span<ComponentBase *> Query(const Archetype<N> &archetype) override {
-    if (!query_cache_.empty()) {
-      return query_cache_;
+  // Keeps the emptied DataPool, so that Column pointers stay valid.
+  void Clear(std::size_t archetype) override {
+    auto it = components_.find(archetype);
+    if (it != components_.end()) {
+      it->second.Clear();
+    }
+  }
+
+  void MoveAll(std::size_t old_archetype, std::size_t new_archetype,
+               bool swap, std::vector<std::size_t> *handles) override {
+    DataPool<T> &old_pool = Storage(old_archetype);
+    DataPool<T> &new_pool = Storage(new_archetype);
+    if (swap) {
+      assert(new_pool.begin() == new_pool.end() && "Swapping into rows");
+      assert(clock_ == nullptr && "Swapping journaled rows");
+      std::swap(old_pool, new_pool);
+      if (tick_ != nullptr) {
+        old_pool.TrackWrites(tick_);
+        new_pool.TrackWrites(tick_);
+      }
+      return;
+    }
+    for (std::size_t old_handle : old_pool.Indices()) {
+      std::size_t handle = new_pool.Insert();
+      new_pool[handle] = std::move(old_pool[old_handle]);
+      if (!old_pool.Enabled(old_handle)) {
+        new_pool.SetEnabled(handle, false);
+      }
+      if (handles != nullptr) {
+        handles->push_back(handle);
+      }
+    }
+    old_pool.Clear();
+  }
+
+  void MoveRows(std::size_t old_archetype,
+                std::span<const std::size_t> handles,
+                ComponentPoolBase &destination, std::size_t new_archetype,
+                std::vector<std::size_t> *new_handles) override {
+    DataPool<T> &old_pool = Storage(old_archetype);
+    DataPool<T> &new_pool =
+        static_cast<ComponentPool &>(destination).Storage(new_archetype);
+    std::vector<std::size_t> taken;
+    taken.reserve(handles.size());
+    new_pool.Fill(T{}, handles.size(), &taken);
+    for (auto [old_handle, handle] : std::views::zip(handles, taken)) {
+      new_pool[handle] = std::move(old_pool[old_handle]);
+      if (!old_pool.Enabled(old_handle)) {
+        new_pool.SetEnabled(handle, false);
+      }
+      old_pool.Erase(old_handle);
+    }
+    if (new_handles != nullptr) {
+      new_handles->insert(new_handles->end(), taken.begin(), taken.end());
+    }
+  }
+
+  void SetEnabled(std::size_t archetype, std::size_t handle,
+                  bool enabled) override {
+    Storage(archetype).SetEnabled(handle, enabled);
+  }
+
+  bool Enabled(std::size_t archetype, std::size_t handle) const override {
+    return components_.at(archetype).Enabled(handle);
+  }
+
+  bool Contains(std::size_t archetype, std::size_t handle) const override {
+    auto it = components_.find(archetype);
+    return it != components_.end() && it->second.Contains(handle);
+  }
+
+  void Save(std::size_t archetype, std::ostream &out) const override {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      WriteVarint(out, sizeof(T));
+      auto it = components_.find(archetype);
+      if (it == components_.end()) {
+        return;
+      }
+      for (const T &value : it->second) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+      }
+    } else {
+      throw std::runtime_error("Component can't be saved");
+    }
+  }
+
+  RegionColumnRef Load(std::istream &in, std::size_t count) const override {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      if (ReadVarint(in) != sizeof(T)) {
+        throw std::runtime_error("Component size mismatch");
+      }
+      auto column = std::make_unique<RegionColumn<T>>();
+      column->rows.Fill(T{}, count);
+      for (T &value : column->rows) {
+        in.read(reinterpret_cast<char *>(&value), sizeof(T));
+      }
+      if (!in) {
+        throw std::runtime_error("Truncated region");
+      }
+      return column;
+    } else {
+      throw std::runtime_error("Component can't be loaded");
+    }
+  }
+
+  void Adopt(std::size_t archetype, RegionColumnBase &column) override {
+    DataPool<T> &rows = static_cast<RegionColumn<T> &>(column).rows;
+    DataPool<T> &pool = Storage(archetype);
+    assert(pool.begin() == pool.end() && "Adopting into rows");
+    // Files are named after the archetypes and journals stay with the
+    // storages, so their rows are copied.
+    if (!directory_.has_value() && clock_ == nullptr) {
+      pool.Clear();
+      std::swap(pool, rows);
+      if (tick_ != nullptr) {
+        pool.TrackWrites(tick_);
+      }
+      return;
+    }
+    pool.Clear();
+    for (T &value : rows) {
+      pool[pool.Insert()] = std::move(value);
+    }
+    rows.Clear();
+  }
+
+  std::vector<std::size_t> Sort(std::size_t archetype,
+                                const ComponentLess &less) const override {
+    auto it = components_.find(archetype);
+    if (it == components_.end()) {
+      return {};
+    }
+    const DataPool<T> &pool = it->second;
+    std::vector<std::size_t> handles = pool.Indices();
+    std::ranges::stable_sort(handles, [&](std::size_t lhs, std::size_t rhs) {
+      return less(pool[lhs], pool[rhs]);
+    });
+    return handles;
+  }
+
+  void Permute(std::size_t archetype,
+               std::span<const std::size_t> handles) override {
+    auto it = components_.find(archetype);
+    if (it != components_.end()) {
+      it->second.Permute(handles);
+    }
+  }
+
+  void *Column(std::size_t archetype) override { return &Storage(archetype); }
+
+  bool MapTo(const std::filesystem::path &directory) override {
+    if constexpr (kMappedFiles && std::is_trivially_copyable_v<T>) {
+      std::filesystem::create_directories(directory);
+      directory_ = directory;
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  void Reopen(std::size_t num_archetypes) override {
+    if (!directory_.has_value()) {
+      return;
+    }
+    assert(components_.empty() && "Reopening filled pools");
+    std::vector<std::size_t> kept;
+    for (const std::filesystem::directory_entry &entry :
+         std::filesystem::directory_iterator(*directory_)) {
+      const std::filesystem::path &path = entry.path();
+      if (path.extension() != ".pool") {
+        continue;
+      }
+      std::string stem = path.stem().string();
+      std::size_t archetype = 0;
+      auto [end, error] =
+          std::from_chars(stem.data(), stem.data() + stem.size(), archetype);
+      if (error == std::errc{} && end == stem.data() + stem.size() &&
+          archetype < num_archetypes) {
+        kept.push_back(archetype);
+      } else {
+        std::filesystem::remove(path);
+      }
+    }
+    for (std::size_t archetype : kept) {
+      Storage(archetype);
+    }
+  }
+
+  void Sync() override {
+    for (auto &[archetype, pool] : components_) {
+      pool.Sync();
     }
-    for (auto &[key_archetype, pool] : components_) {
-      if (archetype.IsPrefix(key_archetype)) {
-        for (T &component : pool) {
-          query_cache_.push_back(&component);
+  }
+
+  void Journal(const ForkClock *clock) override {
+    assert(components_.empty() && !directory_.has_value() &&
+           "Only new pools on the heap can be journaled");
+    clock_ = clock;
+  }
+
+  void Rollback(std::uint64_t fork) override {
+    for (auto &[archetype, pool] : components_) {
+      pool.Rollback(fork);
+    }
+  }
+
+  void TrackWrites(const std::uint64_t *tick) override {
+    assert(components_.empty() && "Only new pools can track writes");
+    tick_ = tick;
+  }
+
+  DataPool<T> &Storage(std::size_t archetype) {
+    auto it = components_.find(archetype);
+    if (it != components_.end()) {
+      return it->second;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      if (directory_.has_value()) {
+        // Files left by another world are removed by Reopen, so an existing
+        // file holds the rows of this archetype.
+        std::filesystem::path path =
+            *directory_ / (std::to_string(archetype) + ".pool");
+        DataPool<T> &pool =
+            components_.try_emplace(archetype, path).first->second;
+        if (tick_ != nullptr) {
+          pool.TrackWrites(tick_);
         }
+        return pool;
       }
     }
-    return std::span<ComponentBase *>{query_cache_.begin(), query_cache_.end()};
+    DataPool<T> &pool = components_[archetype];
+    if (clock_ != nullptr) {
+      pool.Journal(clock_);
+    }
+    if (tick_ != nullptr) {
+      pool.TrackWrites(tick_);
+    }
+    return pool;
+  }
+
+  DataPool<T> *Find(std::size_t archetype) noexcept {
+    auto it = components_.find(archetype);
+    return it == components_.end() ? nullptr : &it->second;
+  }
+
+  const DataPool<T> *Find(std::size_t archetype) const noexcept {
+    auto it = components_.find(archetype);
+    return it == components_.end() ? nullptr : &it->second;
   }
 
  private:
-  std::unordered_map<Archetype<N>, DataPool<T>> components_;
-  mutable std::vector<ComponentBase *> query_cache_;
+  // Nodes of unordered_map are stable, see Column.
+  std::unordered_map<std::size_t, DataPool<T>> components_;
+  // Directory of the files backing the archetypes, see MapTo.
+  std::optional<std::filesystem::path> directory_;
+  // Null unless the archetypes are journaled.
+  const ForkClock *clock_{nullptr};
+  // Null unless the writes are tracked, see TrackWrites.
+  const std::uint64_t *tick_{nullptr};
 };
 
 }  // namespace ecsify::internal
@@ -1,17 +1,29 @@
 #ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_DATA_POOL_H_
 #define ECSIFY_INCLUDE_ECSIFY_INTERNAL_DATA_POOL_H_
 
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <filesystem>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "ecsify/internal/fork_clock.h"
+#include "ecsify/internal/mapped_file.h"
+
 namespace ecsify::internal {
 
 // An iterator that adnvances to the next element based on the mask.
@@ -110,12 +122,39 @@ class Bucket final {
     std::size_t offset = std::countr_zero(free_elements_mask_);
     data_[offset] = T{};
     free_elements_mask_ &= ~GetMaskWithNthBitSet(offset);
+    disabled_mask_ &= ~GetMaskWithNthBitSet(offset);
     return offset;
   }
 
+  // Fills the first count slots of an empty bucket with copies of the value.
+  void Fill(const T &value, std::size_t count) {
+    assert(Empty() && count <= Capacity() && "Bucket can't be filled");
+    std::fill_n(data_.begin(), count, value);
+    free_elements_mask_ =
+        count == Capacity() ? Mask{} : ~(GetMaskWithNthBitSet(count) - 1);
+    disabled_mask_ = Mask{};
+  }
+
   void Erase(std::size_t idx) noexcept {
     assert(Contains(idx) && "Element doesn't exist");
     free_elements_mask_ |= GetMaskWithNthBitSet(idx);
+    disabled_mask_ &= ~GetMaskWithNthBitSet(idx);
+  }
+
+  // Disabled elements stay in the bucket but are skipped by EnabledMask.
+  // Inserted elements are enabled.
+  void SetEnabled(std::size_t idx, bool enabled) noexcept {
+    assert(Contains(idx) && "Element doesn't exist");
+    if (enabled) {
+      disabled_mask_ &= ~GetMaskWithNthBitSet(idx);
+    } else {
+      disabled_mask_ |= GetMaskWithNthBitSet(idx);
+    }
+  }
+
+  bool Enabled(std::size_t idx) const noexcept {
+    assert(Contains(idx) && "Element doesn't exist");
+    return (disabled_mask_ & GetMaskWithNthBitSet(idx)) == 0;
   }
 
   T &operator[](std::size_t idx) noexcept {
@@ -135,6 +174,18 @@ class Bucket final {
 
   bool Full() const noexcept { return free_elements_mask_ == 0; }
 
+  bool Empty() const noexcept {
+    return free_elements_mask_ == std::numeric_limits<Mask>::max();
+  }
+
+  // 1 means occupied, 0 means free.
+  Mask OccupiedMask() const noexcept { return ~free_elements_mask_; }
+
+  // 1 means occupied and enabled.
+  Mask EnabledMask() const noexcept {
+    return ~(free_elements_mask_ | disabled_mask_);
+  }
+
   Iterator begin() noexcept {
     return MaskGuidedIterator{data_.begin(), free_elements_mask_};
   }
@@ -158,6 +209,8 @@ class Bucket final {
   std::array<T, Capacity()> data_{};
   // 1 means free, 0 means occupied.
   Mask free_elements_mask_ = std::numeric_limits<Mask>::max();
+  // 1 means disabled, always 0 for free elements.
+  Mask disabled_mask_{};
 };
 
 template <class T>
@@ -194,7 +247,9 @@ class FlattenedIterator {
 
   FlattenedIterator(OuterIterT outer_it, OuterIterT outer_end,
                     InnerIterT inner_it = InnerIterT{})
-      : outer_it_{outer_it}, outer_end_{outer_end}, inner_it_{inner_it} {}
+      : outer_it_{outer_it}, outer_end_{outer_end}, inner_it_{inner_it} {
+    SkipExhausted();
+  }
 
   reference operator*() const { return *inner_it_; }
 
@@ -202,12 +257,7 @@ class FlattenedIterator {
 
   FlattenedIterator &operator++() {
     ++inner_it_;
-    if (inner_it_ == std::end(*outer_it_)) {
-      ++outer_it_;
-      if (outer_it_ != outer_end_) {
-        inner_it_ = std::begin(*outer_it_);
-      }
-    }
+    SkipExhausted();
     return *this;
   }
 
@@ -222,6 +272,17 @@ class FlattenedIterator {
   }
 
  private:
+  // Advances to the next non-empty inner container if the current one is
+  // exhausted. Past the last container inner_it_ stays at its end.
+  void SkipExhausted() {
+    while (outer_it_ != outer_end_ && inner_it_ == std::end(*outer_it_)) {
+      ++outer_it_;
+      if (outer_it_ != outer_end_) {
+        inner_it_ = std::begin(*outer_it_);
+      }
+    }
+  }
+
   OuterIterT outer_it_;
   OuterIterT outer_end_;
   InnerIterT inner_it_;
@@ -239,6 +300,186 @@ bool operator!=(const FlattenedIterator<OuterIterT> &lhs,
   return !lhs.Equals(rhs);
 }
 
+// Buckets of a DataPool kept either on the heap or in a memory-mapped file.
+// The file starts with a Header followed by the buckets, so it can be mapped
+// again as long as T is trivially copyable. Files can only be mapped on Linux,
+// see kMappedFiles. Buckets on the heap are allocated one by one, so that they
+// can be exchanged without copying their elements.
+template <class T>
+class BucketArray final {
+ public:
+  // Visits the buckets by index wherever they are stored.
+  template <class B>
+  class BucketIterator {
+   public:
+    using Array =
+        std::conditional_t<std::is_const_v<B>, const BucketArray, BucketArray>;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<B>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = B *;
+    using reference = B &;
+
+    BucketIterator() = default;
+    BucketIterator(Array *array, std::size_t idx) : array_{array}, idx_{idx} {}
+
+    reference operator*() const { return (*array_)[idx_]; }
+    pointer operator->() const { return &(*array_)[idx_]; }
+
+    BucketIterator &operator++() {
+      ++idx_;
+      return *this;
+    }
+
+    BucketIterator operator++(int) {
+      BucketIterator tmp = *this;
+      ++idx_;
+      return tmp;
+    }
+
+    friend bool operator==(const BucketIterator &lhs,
+                           const BucketIterator &rhs) {
+      return lhs.idx_ == rhs.idx_;
+    }
+
+   private:
+    Array *array_{nullptr};
+    std::size_t idx_{0};
+  };
+
+  using Iterator = BucketIterator<Bucket<T>>;
+  using ConstIterator = BucketIterator<const Bucket<T>>;
+
+  BucketArray() = default;
+
+  // Maps the file keeping the buckets already stored in it.
+  explicit BucketArray(const std::filesystem::path &path)
+    requires(std::is_trivially_copyable_v<T>)
+      : file_{std::make_unique<MappedFile>(path)} {
+    if (file_->size() == 0) {
+      Reserve(1);
+      return;
+    }
+    const Header &header = GetHeader();
+    if (file_->size() < kDataOffset || header.magic != kMagic ||
+        header.bucket_size != sizeof(Bucket<T>) ||
+        file_->size() < kDataOffset + header.size * sizeof(Bucket<T>)) {
+      throw std::invalid_argument("Incompatible bucket file");
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return file_ == nullptr ? heap_.size() : GetHeader().size;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+  // Drops the buckets past the size or appends empty ones. Only buckets on
+  // the heap can be resized.
+  void resize(std::size_t size) {
+    assert(file_ == nullptr && "Resizing buckets in a file");
+    std::size_t old_size = heap_.size();
+    heap_.resize(size);
+    for (std::size_t idx = old_size; idx < size; ++idx) {
+      heap_[idx] = std::make_unique<Bucket<T>>();
+    }
+  }
+
+  Bucket<T> &operator[](std::size_t idx) noexcept {
+    return file_ == nullptr ? *heap_[idx] : Data()[idx];
+  }
+
+  const Bucket<T> &operator[](std::size_t idx) const noexcept {
+    return file_ == nullptr ? *heap_[idx] : Data()[idx];
+  }
+
+  Bucket<T> &front() noexcept { return (*this)[0]; }
+  const Bucket<T> &front() const noexcept { return (*this)[0]; }
+  Bucket<T> &back() noexcept { return (*this)[size() - 1]; }
+  const Bucket<T> &back() const noexcept { return (*this)[size() - 1]; }
+
+  // Puts the bucket in place of the one at the index and returns the latter.
+  // Only buckets on the heap can be exchanged.
+  std::unique_ptr<Bucket<T>> Exchange(std::size_t idx,
+                                      std::unique_ptr<Bucket<T>> bucket) {
+    assert(file_ == nullptr && "Exchanging buckets in a file");
+    heap_[idx].swap(bucket);
+    return bucket;
+  }
+
+  // Invalidates references into the file like std::vector::emplace_back.
+  Bucket<T> &emplace_back() {
+    if (file_ == nullptr) {
+      return *heap_.emplace_back(std::make_unique<Bucket<T>>());
+    }
+    std::size_t idx = size();
+    Reserve(idx + 1);
+    auto *bucket = new (Data() + idx) Bucket<T>();
+    ++GetHeader().size;
+    return *bucket;
+  }
+
+  // Releases the memory, shrinking the file if there is one.
+  void clear() {
+    if (file_ == nullptr) {
+      heap_.clear();
+      heap_.shrink_to_fit();
+      return;
+    }
+    file_->Resize(0);
+    Reserve(1);
+  }
+
+  // Writes the buckets to the file if there is one.
+  void Sync() {
+    if (file_ != nullptr) {
+      file_->Sync();
+    }
+  }
+
+  Iterator begin() noexcept { return Iterator{this, 0}; }
+  Iterator end() noexcept { return Iterator{this, size()}; }
+  ConstIterator begin() const noexcept { return ConstIterator{this, 0}; }
+  ConstIterator end() const noexcept { return ConstIterator{this, size()}; }
+
+ private:
+  struct Header {
+    std::uint64_t magic;
+    std::uint64_t bucket_size;
+    std::uint64_t size;
+  };
+
+  static constexpr std::uint64_t kMagic = 0x6c6f6f7079666973;  // "sifypool"
+  static constexpr std::size_t kDataOffset =
+      (sizeof(Header) + alignof(Bucket<T>) - 1) / alignof(Bucket<T>) *
+      alignof(Bucket<T>);
+
+  Header &GetHeader() const noexcept {
+    return *reinterpret_cast<Header *>(file_->data());
+  }
+
+  Bucket<T> *Data() const noexcept {
+    return reinterpret_cast<Bucket<T> *>(file_->data() + kDataOffset);
+  }
+
+  // Grows the file geometrically to fit the buckets.
+  void Reserve(std::size_t num_buckets) {
+    std::size_t required = kDataOffset + num_buckets * sizeof(Bucket<T>);
+    if (file_->size() >= required) {
+      return;
+    }
+    bool created = file_->size() == 0;
+    file_->Resize(std::max(required, file_->size() * 2));
+    if (created) {
+      GetHeader() = Header{
+          .magic = kMagic, .bucket_size = sizeof(Bucket<T>), .size = 0};
+    }
+  }
+
+  std::vector<std::unique_ptr<Bucket<T>>> heap_;
+  std::unique_ptr<MappedFile> file_;
+};
+
 /**
  * @brief An unordered stable data structure which stores elements in a
  * contiguous array. It supports indexing and all operations (insertion,
@@ -253,9 +494,29 @@ bool operator!=(const FlattenedIterator<OuterIterT> &lhs,
 template <class T>
 class DataPool final {
  public:
-  using Iterator = FlattenedIterator<typename std::vector<Bucket<T>>::iterator>;
+  using Iterator = FlattenedIterator<typename BucketArray<T>::Iterator>;
   using ConstIterator =
-      FlattenedIterator<typename std::vector<Bucket<T>>::const_iterator>;
+      FlattenedIterator<typename BucketArray<T>::ConstIterator>;
+
+  DataPool() = default;
+
+  /**
+   * @brief Creates a DataPool stored in the memory-mapped file.
+   *
+   * Elements already stored in the file are kept under the same indices. The
+   * OS pages the buckets in and out on demand, which lets the pool outgrow
+   * the memory.
+   */
+  explicit DataPool(const std::filesystem::path &path)
+    requires(std::is_trivially_copyable_v<T>)
+      : buckets_{path} {
+    for (std::size_t bucket_idx = 0; bucket_idx < buckets_.size();
+         ++bucket_idx) {
+      if (!buckets_[bucket_idx].Full()) {
+        partially_filled_buckets_.push_back(bucket_idx);
+      }
+    }
+  }
 
   /**
    * @brief Inserts a new default-constructed element into the DataPool.
@@ -264,34 +525,203 @@ class DataPool final {
    */
   std::size_t Insert() {
     if (partially_filled_buckets_.empty()) {
+      if (Journaled()) {
+        CurrentUndo();
+      }
       std::size_t bucket_idx = buckets_.size();
       Bucket<T> &bucket = buckets_.emplace_back();
+      Written(bucket_idx);
       partially_filled_buckets_.push_back(bucket_idx);
       bucket.Insert();
       return bucket_idx * Bucket<T>::Capacity();
     }
     std::size_t bucket_idx = partially_filled_buckets_.back();
+    Touch(bucket_idx);
     Bucket<T> &bucket = buckets_[bucket_idx];
     std::size_t offset = bucket.Insert();
-    if (bucket.Full() == 0) {
+    if (bucket.Full()) {
       partially_filled_buckets_.pop_back();
     }
     return bucket_idx * Bucket<T>::Capacity() + offset;
   }
 
+  /**
+   * @brief Inserts count copies of the value.
+   *
+   * Free slots are taken in the same order as by Insert. The remaining copies
+   * fill new buckets as a whole. Indices of the inserted elements are appended
+   * to handles if it isn't null.
+   */
+  void Fill(const T &value, std::size_t count,
+            std::vector<std::size_t> *handles = nullptr) {
+    for (; count != 0 && !partially_filled_buckets_.empty(); --count) {
+      std::size_t idx = Insert();
+      (*this)[idx] = value;
+      if (handles != nullptr) {
+        handles->push_back(idx);
+      }
+    }
+    if (count != 0 && Journaled()) {
+      CurrentUndo();
+    }
+    while (count != 0) {
+      std::size_t bucket_idx = buckets_.size();
+      std::size_t filled = std::min(count, Bucket<T>::Capacity());
+      Bucket<T> &bucket = buckets_.emplace_back();
+      Written(bucket_idx);
+      bucket.Fill(value, filled);
+      if (!bucket.Full()) {
+        partially_filled_buckets_.push_back(bucket_idx);
+      }
+      if (handles != nullptr) {
+        for (std::size_t offset = 0; offset < filled; ++offset) {
+          handles->push_back(bucket_idx * Bucket<T>::Capacity() + offset);
+        }
+      }
+      count -= filled;
+    }
+  }
+
   // If the element exists, erase it. Otherwise, leave the container as is.
   void Erase(std::size_t idx) {
     if (!Contains(idx)) {
       return;
     }
     std::size_t bucket_idx = idx / Bucket<T>::Capacity();
+    Touch(bucket_idx);
     Bucket<T> &bucket = buckets_[bucket_idx];
-    if (bucket.Full() == 0) {
+    if (bucket.Full()) {
       partially_filled_buckets_.push_back(bucket_idx);
     }
     bucket.Erase(idx % Bucket<T>::Capacity());
   }
 
+  // Erases all the elements and releases the memory held by the buckets.
+  void Clear() {
+    if (Journaled()) {
+      // The buckets are kept by the journal as a whole unless the pool was
+      // already cleared since the fork.
+      Undo &undo = CurrentUndo();
+      if (!undo.cleared.has_value()) {
+        undo.cleared = std::exchange(buckets_, {});
+      }
+    }
+    buckets_.clear();
+    partially_filled_buckets_ = {};
+  }
+
+  // Copy the buckets on their first change after a fork of the clock, so
+  // that Rollback can undo the changes.
+  void Journal(const ForkClock *clock) noexcept {
+    assert(buckets_.empty() && "Journaling a filled pool");
+    clock_ = clock;
+  }
+
+  bool Journaled() const noexcept {
+    return clock_ != nullptr && clock_->Journaling();
+  }
+
+  // Restore the elements as of the fork. Later journals are dropped.
+  void Rollback(std::uint64_t fork) {
+    for (; !undo_.empty() && undo_.back().fork >= fork; undo_.pop_back()) {
+      Undo &undo = undo_.back();
+      if (undo.cleared.has_value()) {
+        buckets_ = std::move(*undo.cleared);
+      }
+      buckets_.resize(undo.num_buckets);
+      // Buckets copied before the pool was cleared changed before it too.
+      for (auto &[bucket_idx, bucket] : undo.buckets) {
+        buckets_.Exchange(bucket_idx, std::move(bucket));
+      }
+      partially_filled_buckets_ = std::move(undo.partially_filled_buckets);
+    }
+    WrittenAll();
+  }
+
+  // Stamp every bucket with the value of the tick when it's first changed
+  // afterwards, see Version. Buckets already stored count as changed now,
+  // so this is also called after the buckets are swapped with another pool.
+  void TrackWrites(const std::uint64_t *tick) {
+    tick_ = tick;
+    WrittenAll();
+  }
+
+  // The tick of the last change of the bucket, its elements or their masks.
+  // Meaningful only if the writes are tracked.
+  std::uint64_t Version(std::size_t bucket_idx) const noexcept {
+    return bucket_idx < versions_.size() ? versions_[bucket_idx] : 0;
+  }
+
+  // Checks if the elements occupy indices [0, size) without gaps, which is
+  // where Fill puts them in an empty pool.
+  bool Dense() const noexcept {
+    for (std::size_t bucket_idx = 0; bucket_idx < buckets_.size();
+         ++bucket_idx) {
+      typename Bucket<T>::Mask mask = buckets_[bucket_idx].OccupiedMask();
+      bool last = bucket_idx + 1 == buckets_.size();
+      if (last ? (mask & (mask + 1)) != 0 : !buckets_[bucket_idx].Full()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Writes the elements to the file backing the pool if there is one.
+  void Sync() { buckets_.Sync(); }
+
+  // Returns indices of all the elements in the iteration order.
+  std::vector<std::size_t> Indices() const {
+    std::vector<std::size_t> result;
+    for (std::size_t bucket_idx = 0; bucket_idx < buckets_.size();
+         ++bucket_idx) {
+      typename Bucket<T>::Mask mask = buckets_[bucket_idx].OccupiedMask();
+      for (; mask != 0; mask &= mask - 1) {
+        result.push_back(bucket_idx * Bucket<T>::Capacity() +
+                         std::countr_zero(mask));
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Reorders the elements, so that the i-th element becomes the one
+   * previously stored at order[i].
+   *
+   * Elements which aren't listed are erased. Afterwards the elements occupy
+   * indices [0, order.size()) without gaps.
+   */
+  void Permute(std::span<const std::size_t> order) {
+    std::vector<T> values;
+    std::vector<std::size_t> disabled;
+    values.reserve(order.size());
+    for (std::size_t idx : order) {
+      if (!Enabled(idx)) {
+        disabled.push_back(values.size());
+      }
+      values.push_back(std::move((*this)[idx]));
+    }
+    // Refill the same storage, which may be backed by a file.
+    Clear();
+    for (T &value : values) {
+      (*this)[Insert()] = std::move(value);
+    }
+    for (std::size_t idx : disabled) {
+      SetEnabled(idx, false);
+    }
+  }
+
+  // Disabled elements are skipped by queries, see Bucket::EnabledMask.
+  void SetEnabled(std::size_t idx, bool enabled) {
+    std::size_t bucket_idx = idx / Bucket<T>::Capacity();
+    Touch(bucket_idx);
+    buckets_[bucket_idx].SetEnabled(idx % Bucket<T>::Capacity(), enabled);
+  }
+
+  bool Enabled(std::size_t idx) const noexcept {
+    return buckets_[idx / Bucket<T>::Capacity()].Enabled(
+        idx % Bucket<T>::Capacity());
+  }
+
   bool Contains(std::size_t idx) const noexcept {
     std::size_t bucket_idx = idx / Bucket<T>::Capacity();
     if (bucket_idx >= buckets_.size()) {
@@ -310,9 +740,10 @@ class DataPool final {
    * It assumes that the element exists and does not perform any bounds
    * checking.
    */
-  T &operator[](std::size_t idx) noexcept {
+  T &operator[](std::size_t idx) {
     std::size_t bucket_idx = idx / Bucket<T>::Capacity();
     std::size_t bucket_offset = idx % Bucket<T>::Capacity();
+    Touch(bucket_idx);
     Bucket<T> &bucket = buckets_[bucket_idx];
     assert(bucket.Contains(bucket_offset) && "Element doesn't exist");
     return bucket[bucket_offset];
@@ -336,7 +767,35 @@ class DataPool final {
     return bucket[bucket_offset];
   }
 
-  Iterator begin() noexcept {
+  // Hints the CPU to load the element ahead of the access, see
+  // World::GetMany.
+  void Prefetch(std::size_t idx) const noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(
+        &buckets_[idx / Bucket<T>::Capacity()][idx % Bucket<T>::Capacity()]);
+#else
+    static_cast<void>(idx);
+#endif
+  }
+
+  // Buckets give direct access to the rows, see QueryView.
+  std::size_t NumBuckets() const noexcept { return buckets_.size(); }
+
+  Bucket<T> &BucketAt(std::size_t bucket_idx) {
+    Touch(bucket_idx);
+    return buckets_[bucket_idx];
+  }
+
+  const Bucket<T> &BucketAt(std::size_t bucket_idx) const noexcept {
+    return buckets_[bucket_idx];
+  }
+
+  Iterator begin() {
+    for (std::size_t bucket_idx = 0;
+         (Journaled() || tick_ != nullptr) && bucket_idx < buckets_.size();
+         ++bucket_idx) {
+      Touch(bucket_idx);
+    }
     if (buckets_.empty()) {
       return FlattenedIterator{buckets_.begin(), buckets_.end()};
     }
@@ -369,8 +828,86 @@ class DataPool final {
   }
 
  private:
-  std::vector<Bucket<T>> buckets_;
+  // Changes made since a fork, see Journal.
+  struct Undo {
+    std::uint64_t fork;
+    std::size_t num_buckets;
+    std::vector<std::size_t> partially_filled_buckets;
+    // Indices and copies of the buckets changed first.
+    std::vector<std::pair<std::size_t, std::unique_ptr<Bucket<T>>>> buckets;
+    // All the buckets if the pool was cleared.
+    std::optional<BucketArray<T>> cleared;
+  };
+
+  // Returns the journal of the current fork starting it if needed.
+  Undo &CurrentUndo() {
+    assert(Journaled() && "Pool isn't journaled");
+    if (!undo_.empty() && undo_.back().fork == clock_->fork) {
+      return undo_.back();
+    }
+    Undo undo{};
+    // Reuse the memory of a journal which can't be rolled back to anymore.
+    if (!undo_.empty() && undo_.front().fork < clock_->Oldest()) {
+      undo = std::move(undo_.front());
+      undo_.pop_front();
+      undo.buckets.clear();
+      undo.cleared.reset();
+    }
+    undo.fork = clock_->fork;
+    undo.num_buckets = buckets_.size();
+    undo.partially_filled_buckets = partially_filled_buckets_;
+    return undo_.emplace_back(std::move(undo));
+  }
+
+  void Written(std::size_t bucket_idx) {
+    if (tick_ == nullptr) {
+      return;
+    }
+    if (versions_.size() <= bucket_idx) {
+      versions_.resize(bucket_idx + 1);
+    }
+    versions_[bucket_idx] = *tick_;
+  }
+
+  void WrittenAll() {
+    for (std::size_t bucket_idx = 0; bucket_idx < buckets_.size();
+         ++bucket_idx) {
+      Written(bucket_idx);
+    }
+  }
+
+  // Journals the bucket before it's changed.
+  void Touch(std::size_t bucket_idx) {
+    Written(bucket_idx);
+    if (!Journaled()) {
+      return;
+    }
+    if (stamps_.size() <= bucket_idx) {
+      stamps_.resize(bucket_idx + 1);
+    }
+    if (stamps_[bucket_idx] == clock_->stamp) {
+      return;
+    }
+    stamps_[bucket_idx] = clock_->stamp;
+    Undo &undo = CurrentUndo();
+    // Buckets added since the fork are dropped by the rollback anyway.
+    if (!undo.cleared.has_value() && bucket_idx < undo.num_buckets) {
+      undo.buckets.emplace_back(
+          bucket_idx, std::make_unique<Bucket<T>>(buckets_[bucket_idx]));
+    }
+  }
+
+  BucketArray<T> buckets_;
   std::vector<std::size_t> partially_filled_buckets_;
+  // Null unless the pool is journaled.
+  const ForkClock *clock_{nullptr};
+  // Per bucket, the stamp of the clock when it was journaled last.
+  std::vector<std::uint64_t> stamps_;
+  std::deque<Undo> undo_;
+  // Null unless the writes are tracked, see TrackWrites.
+  const std::uint64_t *tick_{nullptr};
+  // Per bucket, the tick of its last change.
+  std::vector<std::uint64_t> versions_;
 };
 
 }  // namespace ecsify::internal
@@ -1,38 +1,40 @@
 #ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_ENTITY_POOL_H_
 #define ECSIFY_INCLUDE_ECSIFY_INTERNAL_ENTITY_POOL_H_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "ecsify/entity.h"
-#include "ecsify/internal/archetype.h"
-#include "ecsify/internal/data_pool.h"
+#include "ecsify/internal/fork_clock.h"
+#include "ecsify/region.h"
 
 namespace ecsify::internal {
 
-template <std::size_t N>
 class EntityData final {
  public:
   EntityData() : id_{-1} {}
-  explicit EntityData(std::int64_t unique_id) : id_{unique_id} {}
+  explicit EntityData(std::int64_t unique_id) : id_{unique_id}, alive_{true} {}
 
-  bool Has(std::size_t component_type) const noexcept {
-    assert(component_type < archetype_.Size() && "Unknown component type");
-    return archetype_.At(component_type);
-  }
+  std::int64_t id() const noexcept { return id_; }
 
-  void Link(std::size_t component_type) noexcept {
-    assert(component_type < archetype_.Size() && "Unknown component type");
-    return archetype_.Set(component_type);
-  }
+  bool alive() const noexcept { return alive_; }
 
-  void Unlink(std::size_t component_type) noexcept {
-    assert(component_type < archetype_.Size() && "Unknown component type");
-    return archetype_.Unset(component_type);
-  }
+  // Only the id is kept, so that the slot can be reused with a new one.
+  void Kill() noexcept { alive_ = false; }
 
-  std::int64_t id() const noexcept { return id_; }
+  // The slot was handed out by EntityPool::Reserve and not materialized yet.
+  bool Pending() const noexcept { return id_ < 0; }
 
   std::size_t component_handle() const noexcept { return component_handle_; }
 
@@ -40,44 +42,368 @@ class EntityData final {
     component_handle_ = new_component_handle;
   }
 
-  const Archetype<N> &archetype() const noexcept { return archetype_; }
+  // Id of the archetype in the ArchetypeRegistry of the world.
+  std::size_t archetype() const noexcept { return archetype_; }
+
+  void archetype(std::size_t new_archetype) noexcept {
+    archetype_ = new_archetype;
+  }
 
  private:
-  Archetype<N> archetype_{};
   std::int64_t id_;
+  bool alive_{false};
+  std::size_t archetype_{0};
   std::size_t component_handle_{};
 };
 
-template <std::size_t N>
+// Entity ids are the handle in the low 32 bits and the number of times the
+// handle was reused in the high bits. Thus handles taken for the first time
+// get the id equal to the handle, which lets Reserve hand out entities with a
+// single atomic increment and nothing else to record. Handles freed before a
+// Flush are reserved again with their next ids, see Recycle.
 class EntityPool {
  public:
+  // Must be called from the thread owning the pool.
   Entity Add() {
-    std::int64_t unique_id = next_entity_id_++;
-    std::size_t handle = entities_.Insert();
-    entities_[handle] = EntityData<N>(unique_id);
+    BeginChange();
+    if (free_.empty()) {
+      std::size_t handle = next_handle_.fetch_add(1, std::memory_order_relaxed);
+      Grow(handle + 1);
+      Touch(handle);
+      entities_[handle] = EntityData(FirstId(handle));
+      return Entity{FirstId(handle), handle};
+    }
+    std::size_t handle = free_.back();
+    free_.pop_back();
+    Touch(handle);
+    std::int64_t unique_id = entities_[handle].id() + kGeneration;
+    entities_[handle] = EntityData(unique_id);
     return Entity{unique_id, handle};
   }
 
-  void Remove(Entity entity) { entities_.Erase(entity.handle()); }
+  // Thread-safe and lock-free. Reserved entities become alive on the next
+  // Flush. Handles recycled by the last Flush are taken first.
+  Entity Reserve() noexcept {
+    Entity entity;
+    if (Pop(1, [&entity](Entity recycled) { entity = recycled; }) == 0) {
+      std::size_t handle =
+          next_handle_.fetch_add(1, std::memory_order_relaxed);
+      entity = Entity{FirstId(handle), handle};
+    }
+    return entity;
+  }
+
+  // Thread-safe and lock-free, see Reserve. Handles of the entities taken
+  // for the first time are consecutive.
+  std::vector<Entity> Reserve(std::size_t count) {
+    std::vector<Entity> result;
+    result.reserve(count);
+    std::size_t recycled =
+        Pop(count, [&result](Entity entity) { result.push_back(entity); });
+    std::size_t first =
+        next_handle_.fetch_add(count - recycled, std::memory_order_relaxed);
+    for (std::size_t handle = first; handle < first + count - recycled;
+         ++handle) {
+      result.emplace_back(FirstId(handle), handle);
+    }
+    return result;
+  }
+
+  // Makes the entities reserved so far alive and passes each of them to the
+  // callback. Must be called from the thread owning the pool, reservations
+  // made concurrently are left for the next call.
+  template <class Callback>
+  void Flush(Callback &&callback) {
+    std::size_t end = next_handle_.load(std::memory_order_relaxed);
+    if (end != flushed_ || !free_.empty() ||
+        available_.load(std::memory_order_relaxed) !=
+            static_cast<std::int64_t>(published_)) {
+      BeginChange();
+    }
+    Recycle(callback);
+    Grow(end);
+    for (std::size_t handle = flushed_; handle < end; ++handle) {
+      if (!entities_[handle].Pending()) {
+        continue;
+      }
+      Touch(handle);
+      entities_[handle] = EntityData(FirstId(handle));
+      callback(Entity{FirstId(handle), handle});
+    }
+    flushed_ = end;
+  }
 
-  const EntityData<N> &operator[](Entity entity) const {
+  void Remove(Entity entity) {
+    if (!Alive(entity)) {
+      return;
+    }
+    BeginChange();
+    Touch(entity.handle());
+    entities_[entity.handle()].Kill();
+    free_.push_back(entity.handle());
+  }
+
+  const EntityData &operator[](Entity entity) const {
     return entities_[entity.handle()];
   }
 
-  EntityData<N> &operator[](Entity entity) {
+  EntityData &operator[](Entity entity) {
+    Touch(entity.handle());
     return entities_[entity.handle()];
   }
 
+  // Copy the entities on their first change after a fork of the clock, see
+  // DataPool::Journal.
+  void Journal(const ForkClock *clock) noexcept { clock_ = clock; }
+
+  // Restore the entities as of the fork. Later journals are dropped.
+  void Rollback(std::uint64_t fork) {
+    for (; !undo_.empty() && undo_.back().fork >= fork; undo_.pop_back()) {
+      Undo &undo = undo_.back();
+      entities_.resize(undo.size);
+      for (auto &[block_idx, block] : undo.blocks) {
+        std::size_t first = block_idx * kBlockSize;
+        std::copy_n(block.begin(), std::min(kBlockSize, undo.size - first),
+                    entities_.begin() + first);
+      }
+      free_ = std::move(undo.free);
+      recycled_ = std::move(undo.recycled);
+      published_ = recycled_.size();
+      available_.store(static_cast<std::int64_t>(published_),
+                       std::memory_order_relaxed);
+      next_handle_.store(undo.next_handle, std::memory_order_relaxed);
+      flushed_ = undo.flushed;
+    }
+  }
+
+  // Number of handles ever handed out, alive or not.
+  std::size_t Capacity() const noexcept { return entities_.size(); }
+
+  // Write the entities and the free handles for Load. Entities reserved
+  // since the last Flush aren't saved.
+  void Save(std::ostream &out) const {
+    WriteVarint(out, entities_.size());
+    for (const EntityData &data : entities_) {
+      // Pending slots have the id -1.
+      WriteVarint(out, static_cast<std::size_t>(data.id() + 1));
+      out.put(static_cast<char>(data.alive()));
+      WriteVarint(out, data.archetype());
+      WriteVarint(out, data.component_handle());
+    }
+    WriteVarint(out, published_ + free_.size());
+    for (std::size_t idx = 0; idx < published_; ++idx) {
+      WriteVarint(out, recycled_[idx].handle());
+    }
+    for (std::size_t handle : free_) {
+      WriteVarint(out, handle);
+    }
+  }
+
+  // Read the entities written by Save into an empty pool. Throws
+  // std::runtime_error if they're malformed.
+  void Load(std::istream &in) {
+    assert(entities_.empty() && !Journaled() && "Loading into a used pool");
+    entities_.resize(ReadVarint(in));
+    for (std::size_t handle = 0; handle < entities_.size(); ++handle) {
+      std::size_t id = ReadVarint(in);
+      bool alive = in.get() != 0;
+      EntityData &data = entities_[handle];
+      if (id == 0) {
+        // Handles reserved but never flushed are free.
+        data = EntityData(FirstId(handle));
+        data.Kill();
+        free_.push_back(handle);
+      } else {
+        data = EntityData(static_cast<std::int64_t>(id - 1));
+        if (!alive) {
+          data.Kill();
+        }
+      }
+      data.archetype(ReadVarint(in));
+      data.component_handle(ReadVarint(in));
+    }
+    std::size_t num_free = ReadVarint(in);
+    for (std::size_t idx = 0; idx < num_free; ++idx) {
+      std::size_t handle = ReadVarint(in);
+      if (handle >= entities_.size() || entities_[handle].alive()) {
+        throw std::runtime_error("Malformed entities");
+      }
+      free_.push_back(handle);
+    }
+    next_handle_.store(entities_.size(), std::memory_order_relaxed);
+    flushed_ = entities_.size();
+  }
+
+  // Returns the entity alive at the handle or a default constructed one.
+  Entity Find(std::size_t handle) const noexcept {
+    if (handle >= entities_.size() || !entities_[handle].alive()) {
+      return Entity{};
+    }
+    return Entity{entities_[handle].id(), handle};
+  }
+
   bool Alive(Entity entity) const noexcept {
-    if (!entities_.Contains(entity.handle())) {
+    if (entity.handle() >= entities_.size()) {
       return false;
     }
-    return entities_[entity.handle()].id() == entity.id();
+    const EntityData &data = entities_[entity.handle()];
+    return data.alive() && data.id() == entity.id();
   }
 
  private:
-  internal::DataPool<EntityData<N>> entities_{};
-  std::int64_t next_entity_id_{0};
+  static constexpr std::int64_t kGeneration = std::int64_t{1} << 32;
+  // Number of entities journaled together.
+  static constexpr std::size_t kBlockSize = 64;
+
+  // Changes made since a fork, see Journal.
+  struct Undo {
+    std::uint64_t fork;
+    std::size_t size;
+    std::vector<std::size_t> free;
+    std::vector<Entity> recycled;
+    std::size_t next_handle;
+    std::size_t flushed;
+    // Indices and contents of the blocks changed first.
+    std::vector<std::pair<std::size_t, std::array<EntityData, kBlockSize>>>
+        blocks;
+  };
+
+  bool Journaled() const noexcept {
+    return clock_ != nullptr && clock_->Journaling();
+  }
+
+  // Must be called before changing the size of the pool or its free list.
+  void BeginChange() {
+    if (Journaled()) {
+      CurrentUndo();
+    }
+  }
+
+  // Returns the journal of the current fork starting it if needed.
+  Undo &CurrentUndo() {
+    if (!undo_.empty() && undo_.back().fork == clock_->fork) {
+      return undo_.back();
+    }
+    Undo undo{};
+    // Reuse the memory of a journal which can't be rolled back to anymore.
+    if (!undo_.empty() && undo_.front().fork < clock_->Oldest()) {
+      undo = std::move(undo_.front());
+      undo_.pop_front();
+      undo.blocks.clear();
+    }
+    undo.fork = clock_->fork;
+    undo.size = entities_.size();
+    undo.free = free_;
+    undo.recycled.assign(recycled_.begin(), recycled_.begin() + published_);
+    undo.next_handle = next_handle_.load(std::memory_order_relaxed);
+    undo.flushed = flushed_;
+    return undo_.emplace_back(std::move(undo));
+  }
+
+  // Journals the block of the entity before it's changed.
+  void Touch(std::size_t handle) {
+    if (!Journaled()) {
+      return;
+    }
+    std::size_t block_idx = handle / kBlockSize;
+    if (stamps_.size() <= block_idx) {
+      stamps_.resize(block_idx + 1);
+    }
+    if (stamps_[block_idx] == clock_->stamp) {
+      return;
+    }
+    stamps_[block_idx] = clock_->stamp;
+    Undo &undo = CurrentUndo();
+    std::size_t first = block_idx * kBlockSize;
+    // Entities added since the fork are dropped by the rollback anyway.
+    if (first < undo.size) {
+      auto &[idx, block] = undo.blocks.emplace_back();
+      idx = block_idx;
+      std::copy_n(entities_.begin() + first,
+                  std::min(kBlockSize, undo.size - first), block.begin());
+    }
+  }
+
+  // Takes up to count recycled entities passing them to the callback.
+  // Returns their number.
+  template <class Callback>
+  std::size_t Pop(std::size_t count, Callback &&callback) noexcept {
+    // Both are sequentially consistent, so that Recycle either sees the pop
+    // in progress or the pop sees no entities available.
+    popping_.fetch_add(1);
+    std::int64_t end = available_.fetch_sub(static_cast<std::int64_t>(count));
+    std::int64_t begin = std::max<std::int64_t>(
+        end - static_cast<std::int64_t>(count), 0);
+    for (std::int64_t idx = begin; idx < end; ++idx) {
+      callback(recycled_[static_cast<std::size_t>(idx)]);
+    }
+    popping_.fetch_sub(1, std::memory_order_release);
+    return end > begin ? static_cast<std::size_t>(end - begin) : 0;
+  }
+
+  // Materializes the recycled entities taken by Reserve and makes the handles
+  // freed since the last call available to it. The recycled entities are
+  // left as they are while a Reserve may be reading them.
+  template <class Callback>
+  void Recycle(Callback &callback) {
+    auto left = static_cast<std::size_t>(std::clamp<std::int64_t>(
+        available_.exchange(0), 0, static_cast<std::int64_t>(published_)));
+    for (std::size_t idx = left; idx < published_; ++idx) {
+      Entity entity = recycled_[idx];
+      Touch(entity.handle());
+      entities_[entity.handle()] = EntityData(entity.id());
+      callback(entity);
+    }
+    published_ = left;
+    // Otherwise the taken entities stay in the array until the next call.
+    if (popping_.load() == 0) {
+      recycled_.resize(published_);
+      for (std::size_t handle : free_) {
+        recycled_.emplace_back(entities_[handle].id() + kGeneration, handle);
+      }
+      free_.clear();
+      published_ = recycled_.size();
+    }
+    available_.store(static_cast<std::int64_t>(published_),
+                     std::memory_order_release);
+  }
+
+  static std::int64_t FirstId(std::size_t handle) noexcept {
+    assert(handle < static_cast<std::size_t>(kGeneration) &&
+           "Too many entities");
+    return static_cast<std::int64_t>(handle);
+  }
+
+  // Slots between the previous size and the handle stay pending.
+  void Grow(std::size_t size) {
+    if (entities_.size() < size) {
+      entities_.resize(size);
+    }
+  }
+
+  std::vector<EntityData> entities_{};
+  // Handles of removed entities, reused in LIFO order by Add until the next
+  // Flush moves them to recycled_.
+  std::vector<std::size_t> free_{};
+  // Entities handed out by Reserve from the end, see Pop. Only changed by
+  // Recycle while no Reserve reads it.
+  std::vector<Entity> recycled_{};
+  // Number of the recycled entities made available by the last Flush.
+  std::size_t published_{0};
+  // Number of the published entities not handed out yet, negative once
+  // Reserve asked for more.
+  std::atomic<std::int64_t> available_{0};
+  // Number of the Reserve calls reading recycled_.
+  std::atomic<std::size_t> popping_{0};
+  // Handles below were handed out at least once.
+  std::atomic<std::size_t> next_handle_{0};
+  // Handles below were checked by Flush.
+  std::size_t flushed_{0};
+  // Null unless the pool is journaled.
+  const ForkClock *clock_{nullptr};
+  // Per block, the stamp of the clock when it was journaled last.
+  std::vector<std::uint64_t> stamps_;
+  std::deque<Undo> undo_;
 };
 
 }  // namespace ecsify::internal
@@ -0,0 +1,32 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_FORK_CLOCK_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_FORK_CLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecsify::internal {
+
+// Shared by the storages of a world which journal their changes, see
+// World::Fork. Storages copy a block on its first change after a fork or a
+// rollback and put the copy under the current fork, so rolling back to a
+// fork undoes the journals of it and of all the later ones.
+struct ForkClock {
+  // Number of the latest forks kept, see WorldBuilder::Rollback.
+  std::size_t depth{0};
+  // Id of the latest fork, zero before the first one.
+  std::uint64_t fork{0};
+  // Advanced by every fork and rollback. Blocks copied at the current stamp
+  // aren't copied again.
+  std::uint64_t stamp{0};
+
+  bool Journaling() const noexcept { return fork != 0; }
+
+  // Journals of the forks before it are dropped.
+  std::uint64_t Oldest() const noexcept {
+    return fork < depth ? 1 : fork - depth + 1;
+  }
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_FORK_CLOCK_H_
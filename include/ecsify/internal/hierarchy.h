@@ -0,0 +1,247 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_HIERARCHY_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_HIERARCHY_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "ecsify/entity.h"
+#include "ecsify/hierarchy.h"
+#include "ecsify/internal/fork_clock.h"
+
+namespace ecsify::internal {
+
+/**
+ * @brief Parent/child relations between entities.
+ *
+ * Relations are indexed by entity handles, so all the operations except
+ * unlinking (which is linear in the number of siblings) take O(1). Nodes keep
+ * their entities, so stale entities are reported as unlinked. The
+ * breadth-first traversal is cached and rebuilt lazily after the relations
+ * change. Like the entities, nodes can be journaled in blocks for
+ * World::Fork.
+ */
+class Hierarchy final {
+ public:
+  // Make parent the parent of child, detaching it from the previous one.
+  void Link(Entity child, Entity parent) {
+    assert(!IsDescendant(parent, child) && "Hierarchy must be acyclic");
+    Unlink(child);
+    At(child).parent = parent;
+    At(parent).children.push_back(child);
+    dirty_ = true;
+    ++version_;
+  }
+
+  // Detach the child from its parent, so it becomes a root.
+  void Unlink(Entity child) {
+    const Node *node = Find(child);
+    if (node == nullptr || IsNull(node->parent)) {
+      return;
+    }
+    Entity parent = node->parent;
+    std::vector<Entity> &siblings = Mutable(parent.handle()).children;
+    siblings.erase(std::ranges::find(siblings, child));
+    Mutable(child.handle()).parent = Entity{};
+    dirty_ = true;
+    ++version_;
+  }
+
+  // Detach the entity from its parent and its children.
+  void Erase(Entity entity) {
+    const Node *found = Find(entity);
+    if (found == nullptr) {
+      return;
+    }
+    Unlink(entity);
+    if (found->children.empty()) {
+      return;
+    }
+    Node &node = Mutable(entity.handle());
+    for (Entity child : node.children) {
+      Mutable(child.handle()).parent = Entity{};
+    }
+    node.children.clear();
+    dirty_ = true;
+    ++version_;
+  }
+
+  // Return the parent of the entity or a default constructed entity for
+  // roots.
+  Entity Parent(Entity child) const {
+    const Node *node = Find(child);
+    return node == nullptr ? Entity{} : node->parent;
+  }
+
+  std::span<const Entity> Children(Entity parent) const {
+    const Node *node = Find(parent);
+    if (node == nullptr) {
+      return {};
+    }
+    return node->children;
+  }
+
+  // Changes whenever the relations change.
+  std::uint64_t version() const noexcept { return version_; }
+
+  // Move the nodes aside on their first change after a fork of the clock,
+  // see DataPool::Journal.
+  void Journal(const ForkClock *clock) noexcept { clock_ = clock; }
+
+  // Restore the relations as of the fork. Later journals are dropped.
+  void Rollback(std::uint64_t fork) {
+    for (; !undo_.empty() && undo_.back().fork >= fork; undo_.pop_back()) {
+      Undo &undo = undo_.back();
+      nodes_.resize(undo.size);
+      for (auto &[block_idx, block] : undo.blocks) {
+        std::ranges::move(block, nodes_.begin() + block_idx * kBlockSize);
+      }
+      dirty_ = true;
+      ++version_;
+    }
+  }
+
+  // Return all linked entities in breadth-first order, starting from roots
+  // ordered by handle.
+  std::span<const HierarchyNode> Traverse() {
+    if (!dirty_) {
+      return order_;
+    }
+    order_.clear();
+    for (const Node &node : nodes_) {
+      if (IsNull(node.parent) && !node.children.empty()) {
+        order_.push_back(HierarchyNode{.entity = node.entity,
+                                       .parent = HierarchyNode::kNoParent});
+      }
+    }
+    for (std::size_t idx = 0; idx < order_.size(); ++idx) {
+      for (Entity child : nodes_[order_[idx].entity.handle()].children) {
+        order_.push_back(HierarchyNode{.entity = child, .parent = idx});
+      }
+    }
+    dirty_ = false;
+    return order_;
+  }
+
+ private:
+  // Number of nodes journaled together.
+  static constexpr std::size_t kBlockSize = 64;
+
+  struct Node {
+    Entity entity;
+    Entity parent;
+    std::vector<Entity> children;
+  };
+
+  // Changes made since a fork, see Journal.
+  struct Undo {
+    std::uint64_t fork;
+    std::size_t size;
+    // Indices and contents of the blocks changed first. Blocks past the size
+    // are cut short.
+    std::vector<std::pair<std::size_t, std::vector<Node>>> blocks;
+  };
+
+  static bool IsNull(Entity entity) noexcept { return entity.id() < 0; }
+
+  Node &At(Entity entity) {
+    if (entity.handle() >= nodes_.size()) {
+      if (Journaled()) {
+        CurrentUndo();
+      }
+      nodes_.resize(entity.handle() + 1);
+    }
+    Node &node = Mutable(entity.handle());
+    node.entity = entity;
+    return node;
+  }
+
+  // Returns the node journaling its block first.
+  Node &Mutable(std::size_t handle) {
+    Touch(handle);
+    return nodes_[handle];
+  }
+
+  // Returns null unless the node belongs to the entity, so that stale
+  // entities sharing the handle with a newer one are never linked.
+  const Node *Find(Entity entity) const {
+    if (entity.handle() >= nodes_.size() ||
+        nodes_[entity.handle()].entity != entity) {
+      return nullptr;
+    }
+    return &nodes_[entity.handle()];
+  }
+
+  bool IsDescendant(Entity entity, Entity ancestor) const {
+    for (; !IsNull(entity); entity = Parent(entity)) {
+      if (entity == ancestor) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Journaled() const noexcept {
+    return clock_ != nullptr && clock_->Journaling();
+  }
+
+  // Returns the journal of the current fork starting it if needed.
+  Undo &CurrentUndo() {
+    if (!undo_.empty() && undo_.back().fork == clock_->fork) {
+      return undo_.back();
+    }
+    Undo undo{};
+    // Reuse the memory of a journal which can't be rolled back to anymore.
+    if (!undo_.empty() && undo_.front().fork < clock_->Oldest()) {
+      undo = std::move(undo_.front());
+      undo_.pop_front();
+      undo.blocks.clear();
+    }
+    undo.fork = clock_->fork;
+    undo.size = nodes_.size();
+    return undo_.emplace_back(std::move(undo));
+  }
+
+  // Journals the block of the node before it's changed.
+  void Touch(std::size_t handle) {
+    if (!Journaled()) {
+      return;
+    }
+    std::size_t block_idx = handle / kBlockSize;
+    if (stamps_.size() <= block_idx) {
+      stamps_.resize(block_idx + 1);
+    }
+    if (stamps_[block_idx] == clock_->stamp) {
+      return;
+    }
+    stamps_[block_idx] = clock_->stamp;
+    Undo &undo = CurrentUndo();
+    std::size_t first = block_idx * kBlockSize;
+    // Nodes added since the fork are dropped by the rollback anyway.
+    if (first < undo.size) {
+      std::size_t last = std::min(first + kBlockSize, undo.size);
+      undo.blocks.emplace_back(
+          block_idx, std::vector<Node>(nodes_.begin() + first,
+                                       nodes_.begin() + last));
+    }
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<HierarchyNode> order_;
+  bool dirty_{false};
+  std::uint64_t version_{0};
+  // Null unless the nodes are journaled.
+  const ForkClock *clock_{nullptr};
+  // Per block, the stamp of the clock when it was journaled last.
+  std::vector<std::uint64_t> stamps_;
+  std::deque<Undo> undo_;
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_HIERARCHY_H_
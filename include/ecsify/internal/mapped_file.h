@@ -0,0 +1,122 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_MAPPED_FILE_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_MAPPED_FILE_H_
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <system_error>
+
+namespace ecsify::internal {
+
+#ifdef __linux__
+inline constexpr bool kMappedFiles = true;
+#else
+// Other systems than Linux keep all the components on the heap.
+inline constexpr bool kMappedFiles = false;
+#endif
+
+// A file mapped into memory in full. The OS pages it in and out on demand.
+// Failures of the system calls are reported with std::system_error.
+class MappedFile final {
+ public:
+#ifdef __linux__
+  // Opens the file creating it if needed. Existing contents are kept.
+  explicit MappedFile(const std::filesystem::path &path)
+      : fd_{::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)} {
+    if (fd_ < 0) {
+      Fail("open");
+    }
+    try {
+      struct stat info {};
+      if (::fstat(fd_, &info) != 0) {
+        Fail("fstat");
+      }
+      Map(static_cast<std::size_t>(info.st_size));
+    } catch (...) {
+      ::close(fd_);
+      throw;
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    Unmap();
+    ::close(fd_);
+  }
+
+  std::byte *data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+
+  // Truncates or extends the file with zeros and maps it again, which
+  // invalidates pointers into the mapping.
+  void Resize(std::size_t size) {
+    Unmap();
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      Fail("ftruncate");
+    }
+    Map(size);
+  }
+
+  // Waits until the changes are written to the file.
+  void Sync() {
+    if (data_ != nullptr && ::msync(data_, size_, MS_SYNC) != 0) {
+      Fail("msync");
+    }
+  }
+
+ private:
+  [[noreturn]] static void Fail(const char *what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  void Map(std::size_t size) {
+    size_ = size;
+    if (size == 0) {
+      return;
+    }
+    void *data =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      size_ = 0;
+      Fail("mmap");
+    }
+    data_ = static_cast<std::byte *>(data);
+  }
+
+  void Unmap() noexcept {
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  int fd_;
+  std::byte *data_{nullptr};
+  std::size_t size_{0};
+#else
+  // Files are never mapped on other systems than Linux, see kMappedFiles.
+  explicit MappedFile(const std::filesystem::path &) {
+    throw std::system_error(std::make_error_code(std::errc::not_supported),
+                            "mmap");
+  }
+
+  std::byte *data() const noexcept { return nullptr; }
+  std::size_t size() const noexcept { return 0; }
+  void Resize(std::size_t) {}
+  void Sync() {}
+#endif
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_MAPPED_FILE_H_
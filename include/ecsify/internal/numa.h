@@ -0,0 +1,106 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_NUMA_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_NUMA_H_
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace ecsify::internal {
+
+struct NumaNode {
+  // Node number of the kernel.
+  int id;
+  std::vector<int> cpus;
+};
+
+// Parses CPU lists like "0-3,8,10-11".
+inline std::vector<int> ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::istringstream stream{list};
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    std::size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// Nodes having CPUs in the order of their ids. Machines without NUMA and
+// other systems than Linux are reported as a single node with no CPUs listed.
+inline std::vector<NumaNode> NumaNodes() {
+  std::vector<NumaNode> nodes;
+#ifdef __linux__
+  const std::filesystem::path root{"/sys/devices/system/node"};
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator{root, error}) {
+    std::string name = entry.path().filename().string();
+    if (!name.starts_with("node") || name.size() == 4 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    std::ifstream file{entry.path() / "cpulist"};
+    std::string list;
+    std::getline(file, list);
+    std::vector<int> cpus = ParseCpuList(list);
+    if (!cpus.empty()) {
+      nodes.push_back(NumaNode{.id = std::stoi(name.substr(4)),
+                               .cpus = std::move(cpus)});
+    }
+  }
+  std::ranges::sort(nodes, {}, &NumaNode::id);
+#endif
+  if (nodes.empty()) {
+    nodes.push_back(NumaNode{.id = 0, .cpus = {}});
+  }
+  return nodes;
+}
+
+// Restricts the calling thread to the CPUs of the node and makes the memory it
+// touches first come from the node. Best effort: the thread runs anywhere if
+// the system refuses.
+inline void BindThreadToNode(const NumaNode &node) {
+#ifdef __linux__
+  if (!node.cpus.empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : node.cpus) {
+      CPU_SET(cpu, &cpus);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+  // MPOL_PREFERRED of <numaif.h>, spelled out to avoid depending on libnuma.
+  constexpr int kPreferred = 1;
+  constexpr int kMaxNodes = 8 * sizeof(unsigned long);
+  if (node.id < kMaxNodes) {
+    unsigned long mask = 1UL << node.id;
+    syscall(SYS_set_mempolicy, kPreferred, &mask, kMaxNodes + 1);
+  }
+#else
+  (void)node;
+#endif
+}
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_NUMA_H_
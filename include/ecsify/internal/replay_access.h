@@ -0,0 +1,47 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_REPLAY_ACCESS_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_REPLAY_ACCESS_H_
+
+#include <cstddef>
+#include <span>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/world.h"
+
+namespace ecsify::internal {
+
+// The calls of the untyped interface of World recorded in traces, see
+// TraceOp. Lets benchmarks/trace_replay.cc play traces back without knowing
+// the component types.
+class ReplayAccess final {
+ public:
+  ReplayAccess() = delete;
+
+  static void Add(World &world, Entity entity, std::size_t component_type) {
+    world.Add(entity, component_type);
+  }
+
+  static void Remove(World &world, Entity entity,
+                     std::size_t component_type) {
+    world.Remove(entity, component_type);
+  }
+
+  static bool Has(const World &world, Entity entity,
+                  std::size_t component_type) {
+    return world.Has(entity, component_type);
+  }
+
+  static ComponentBase &Get(World &world, Entity entity,
+                            std::size_t component_type) {
+    return world.Get(entity, component_type);
+  }
+
+  static std::span<void *const> Query(World &world, std::size_t component_type,
+                                      std::span<std::size_t> component_ids) {
+    return world.QueryOne(component_type, component_ids);
+  }
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_REPLAY_ACCESS_H_
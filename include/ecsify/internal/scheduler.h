@@ -0,0 +1,157 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_SCHEDULER_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_SCHEDULER_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ecsify/schedule.h"
+#include "ecsify/task.h"
+
+namespace ecsify {
+
+class World;
+
+namespace internal {
+
+using SystemFunctionType = std::function<void(World &)>;
+
+struct GroupConfig {
+  std::string name;
+  Rate rate;
+  Phase phase;
+};
+
+struct SystemConfig {
+  SystemFunctionType function;
+  // Name of the group. Systems without one run every tick in their phase.
+  std::string group;
+  Phase phase = Phase::kUpdate;
+};
+
+/**
+ * @brief Runs systems by phases and groups.
+ *
+ * Within a tick phases run in order. Within a phase the systems without a
+ * group run first, followed by the groups in their registration order. Every
+ * group is run according to its rate.
+ */
+class Scheduler final {
+ public:
+  Scheduler() = default;
+
+  Scheduler(std::vector<GroupConfig> groups,
+            std::vector<SystemConfig> systems) {
+    for (std::size_t phase = 0; phase < kNumPhases; ++phase) {
+      groups_.push_back(Group{.name = {},
+                              .rate = EveryTick{},
+                              .phase = static_cast<Phase>(phase)});
+    }
+    for (GroupConfig &group : groups) {
+      assert(!group.name.empty() && "Groups must have names");
+      groups_.push_back(Group{.name = std::move(group.name),
+                              .rate = group.rate,
+                              .phase = group.phase});
+    }
+    std::ranges::stable_sort(groups_, {}, &Group::phase);
+    for (SystemConfig &system : systems) {
+      auto group = std::ranges::find_if(groups_, [&](const Group &group) {
+        return group.name == system.group &&
+               (!system.group.empty() || group.phase == system.phase);
+      });
+      assert(group != groups_.end() && "Unknown system group");
+      group->systems.push_back(std::move(system.function));
+    }
+    for (Group &group : groups_) {
+      for (SystemFunctionType &system : group.systems) {
+        if (auto *coroutine = system.target<CoroutineSystem>()) {
+          coroutines_.push_back(coroutine);
+        }
+      }
+    }
+  }
+
+  // Scheduler refers to the systems it owns.
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  void Run(World &world, Duration delta_time) {
+    auto group = groups_.begin();
+    for (std::size_t phase_idx = 0; phase_idx < kNumPhases; ++phase_idx) {
+      auto phase = static_cast<Phase>(phase_idx);
+      ResumeWaiting(phase);
+      for (; group != groups_.end() && group->phase == phase; ++group) {
+        std::visit(
+            [&](const auto &rate) { Run(world, *group, rate, delta_time); },
+            group->rate);
+      }
+    }
+  }
+
+  // Time step of the group being run.
+  Duration delta_time() const noexcept { return delta_time_; }
+
+ private:
+  struct Group {
+    std::string name;
+    Rate rate;
+    Phase phase;
+    std::vector<SystemFunctionType> systems;
+    // Time since the group last ran (or the unsimulated remainder).
+    Duration accumulated{};
+    std::size_t ticks{0};
+  };
+
+  void Run(World &world, Group &group, EveryTick /*rate*/,
+           Duration delta_time) {
+    RunSystems(world, group, delta_time);
+  }
+
+  void Run(World &world, Group &group, const FixedStep &rate,
+           Duration delta_time) {
+    group.accumulated += delta_time;
+    for (std::size_t step = 0;
+         step < rate.max_steps && group.accumulated >= rate.step; ++step) {
+      RunSystems(world, group, rate.step);
+      group.accumulated -= rate.step;
+    }
+    // Drop the steps which didn't fit, so the group doesn't fall behind.
+    group.accumulated %= rate.step;
+  }
+
+  void Run(World &world, Group &group, const TickDivisor &rate,
+           Duration delta_time) {
+    group.accumulated += delta_time;
+    if (group.ticks++ % rate.divisor == 0) {
+      RunSystems(world, group, std::exchange(group.accumulated, Duration{}));
+    }
+  }
+
+  void RunSystems(World &world, const Group &group, Duration delta_time) {
+    delta_time_ = delta_time;
+    for (const SystemFunctionType &system : group.systems) {
+      system(world);
+    }
+  }
+
+  void ResumeWaiting(Phase phase) {
+    for (CoroutineSystem *coroutine : coroutines_) {
+      coroutine->Resume(phase);
+    }
+  }
+
+  std::vector<Group> groups_;
+  std::vector<CoroutineSystem *> coroutines_;
+  Duration delta_time_{};
+};
+
+}  // namespace internal
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_SCHEDULER_H_
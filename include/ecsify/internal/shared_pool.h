@@ -0,0 +1,105 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_SHARED_POOL_H_
+#define ECSIFY_INCLUDE_ECSIFY_INTERNAL_SHARED_POOL_H_
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include "ecsify/component.h"
+#include "ecsify/internal/component_pool.h"
+#include "ecsify/region.h"
+
+namespace ecsify::internal {
+
+// Stores every distinct value of a shared component once. Archetypes refer to
+// the values by their ids, see ArchetypeRegistry::Share. Values are never
+// dropped, so the ids stay valid for the lifetime of the world and across
+// rollbacks.
+struct SharedPoolBase {
+  virtual ~SharedPoolBase() = default;
+
+  // The reference stays valid for the lifetime of the pool.
+  virtual const ComponentBase &Get(std::size_t value) const = 0;
+  // Returns the id of the value equal to the given one storing a copy if
+  // there's none.
+  virtual std::size_t Intern(const ComponentBase &value) = 0;
+  // Write the value like ComponentPool::Save writes a single row.
+  virtual void Save(std::size_t value, std::ostream &out) const = 0;
+  // Intern the single row of a column read by ComponentPool::Load.
+  virtual std::size_t Adopt(RegionColumnBase &column) = 0;
+};
+
+using SharedPoolRef = std::unique_ptr<SharedPoolBase>;
+
+template <class T>
+concept Hashable = requires(const T &value) {
+  { std::hash<T>{}(value) } -> std::convertible_to<std::size_t>;
+};
+
+template <std::equality_comparable T>
+class SharedPool final : public SharedPoolBase {
+ public:
+  // Components are added with the default value, so it takes id zero.
+  SharedPool() { Intern(T{}); }
+
+  const T &Get(std::size_t value) const override {
+    assert(value < values_.size() && "Unknown shared value");
+    return values_[value];
+  }
+
+  std::size_t Intern(const ComponentBase &value) override {
+    const T &shared = static_cast<const T &>(value);
+    if constexpr (Hashable<T>) {
+      std::size_t hash = std::hash<T>{}(shared);
+      auto [first, last] = ids_.equal_range(hash);
+      for (auto it = first; it != last; ++it) {
+        if (values_[it->second] == shared) {
+          return it->second;
+        }
+      }
+      ids_.emplace(hash, values_.size());
+    } else {
+      // Types without std::hash are looked up linearly, which is fine for the
+      // handful of values shared components usually take.
+      for (std::size_t id = 0; id < values_.size(); ++id) {
+        if (values_[id] == shared) {
+          return id;
+        }
+      }
+    }
+    values_.push_back(shared);
+    return values_.size() - 1;
+  }
+
+  void Save(std::size_t value, std::ostream &out) const override {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      WriteVarint(out, sizeof(T));
+      out.write(reinterpret_cast<const char *>(&Get(value)), sizeof(T));
+    } else {
+      throw std::runtime_error("Component can't be saved");
+    }
+  }
+
+  std::size_t Adopt(RegionColumnBase &column) override {
+    const DataPool<T> &rows = static_cast<RegionColumn<T> &>(column).rows;
+    assert(rows.begin() != rows.end() && "Column is empty");
+    return Intern(*rows.begin());
+  }
+
+ private:
+  // Elements of a deque don't move when it grows, see Get.
+  std::deque<T> values_;
+  // Ids of the values by their hashes, unused unless T is hashable.
+  std::unordered_multimap<std::size_t, std::size_t> ids_;
+};
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_INTERNAL_SHARED_POOL_H_
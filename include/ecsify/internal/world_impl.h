@@ -1,137 +1,1397 @@
 #ifndef ECSIFY_INCLUDE_ECSIFY_INTERNAL_WORLD_IMPL_H_
 #define ECSIFY_INCLUDE_ECSIFY_INTERNAL_WORLD_IMPL_H_
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <map>
 #include <memory>
+#include <optional>
 #include <ranges>
 #include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "ecsify/component.h"
+#include "ecsify/component_observer.h"
+#include "ecsify/component_tracker.h"
 #include "ecsify/entity.h"
+#include "ecsify/event_channel.h"
+#include "ecsify/hierarchy.h"
 #include "ecsify/internal/archetype.h"
+#include "ecsify/internal/archetype_registry.h"
+#include "ecsify/internal/change_log.h"
 #include "ecsify/internal/component_pool.h"
 #include "ecsify/internal/entity_pool.h"
+#include "ecsify/internal/fork_clock.h"
+#include "ecsify/internal/hierarchy.h"
+#include "ecsify/internal/scheduler.h"
+#include "ecsify/internal/shared_pool.h"
+#include "ecsify/region.h"
+#include "ecsify/resource.h"
+#include "ecsify/schedule.h"
+#include "ecsify/shared.h"
+#include "ecsify/snapshot.h"
+#include "ecsify/trace.h"
 #include "ecsify/world.h"
 
 namespace ecsify::internal {
 
-using SystemFunctionType = std::function<void(World &)>;
+using ComponentTrackerRef = std::shared_ptr<ComponentTrackerBase>;
+using ComponentObserverRef = std::shared_ptr<ComponentObserverBase>;
+
+inline constexpr std::array<char, 8> kStateMagic = {'e', 'c', 's', 'i',
+                                                    'f', 'y', 'w', '1'};
+
+// Everything WorldBuilder collects besides the component types.
+struct WorldConfig {
+  std::vector<GroupConfig> groups;
+  std::vector<SystemConfig> systems;
+  std::vector<std::pair<std::size_t, ComponentTrackerRef>> trackers;
+  std::vector<std::pair<std::size_t, ComponentObserverRef>> observers;
+  std::vector<std::pair<std::size_t, ComponentLess>> sort_keys;
+  // Event type ids and the factories of their channels.
+  std::vector<std::pair<std::size_t, EventChannelRef (*)()>> events;
+  std::vector<std::pair<std::size_t, ResourceFactory>> resources;
+  // Component types and the directories of the files storing them.
+  std::vector<std::pair<std::size_t, std::filesystem::path>> mapped;
+  // File keeping the rest of a world stored in files, so that it can be
+  // restored, see WorldBuilder::PageToFiles.
+  std::optional<std::filesystem::path> state;
+  // File recording the calls, see WorldBuilder::RecordTrace.
+  std::optional<std::filesystem::path> trace;
+  // Component types published as snapshots and the factories of their
+  // buffers.
+  std::vector<std::pair<std::size_t, SnapshotBufferRef (*)()>> snapshots;
+  // Hot components and their cold parts, see WorldBuilder::Split.
+  std::vector<std::pair<std::size_t, std::size_t>> splits;
+  // Shared component types and the factories of their pools, see
+  // WorldBuilder::Shared.
+  std::vector<std::pair<std::size_t, SharedPoolRef (*)()>> shared;
+  // Sizes of the components by type id, stored in the trace header.
+  std::vector<std::size_t> component_sizes;
+  // Number of forks kept, see WorldBuilder::Rollback.
+  std::size_t rollback_depth{0};
+};
 
 template <std::size_t N>
 class WorldImpl : public World {
  public:
-  explicit WorldImpl(std::array<ComponentPoolRef<N>, N> pools,
-                     std::vector<SystemFunctionType> systems)
-      : components_{std::move(pools)}, systems_{std::move(systems)} {}
+  WorldImpl(std::array<ComponentPoolRef, N> pools, WorldConfig config)
+      : components_{std::move(pools)},
+        scheduler_{std::move(config.groups), std::move(config.systems)},
+        sort_keys_{std::move(config.sort_keys)} {
+    for (auto &[component_type, tracker] : config.trackers) {
+      trackers_[component_type].push_back(std::move(tracker));
+    }
+    for (auto &[component_type, observer] : config.observers) {
+      if (observers_[component_type].empty()) {
+        observed_.push_back(component_type);
+      }
+      observers_[component_type].push_back(std::move(observer));
+    }
+    for (auto [event_type, make_channel] : config.events) {
+      if (channels_.size() <= event_type) {
+        channels_.resize(event_type + 1);
+      }
+      channels_[event_type] = make_channel();
+    }
+    for (std::size_t component_type = 0; component_type < N;
+         ++component_type) {
+      parts_[component_type] = {component_type};
+    }
+    for (auto [hot, cold] : config.splits) {
+      std::vector<std::size_t> parts = parts_[hot];
+      for (std::size_t part : parts_[cold]) {
+        if (std::ranges::find(parts, part) == parts.end()) {
+          parts.push_back(part);
+        }
+      }
+      for (std::size_t part : parts) {
+        parts_[part] = parts;
+      }
+    }
+    for (auto [component_type, make_buffer] : config.snapshots) {
+      snapshots_[component_type] = make_buffer();
+      // Publish copies only the buckets changed since the buffer was filled.
+      components_[component_type]->TrackWrites(&tick_);
+      components_[Entity::TypeID()]->TrackWrites(&tick_);
+    }
+    for (auto [component_type, make_pool] : config.shared) {
+      assert(trackers_[component_type].empty() &&
+             observers_[component_type].empty() &&
+             snapshots_[component_type] == nullptr &&
+             parts_[component_type].size() == 1 &&
+             std::ranges::find(sort_keys_, component_type, &SortKey::first) ==
+                 sort_keys_.end() &&
+             "Shared components are only set, read and queried by value");
+      shared_[component_type] = make_pool();
+      archetypes_.MarkShared(component_type);
+    }
+    std::array<bool, N> mapped{};
+    for (const auto &[component_type, directory] : config.mapped) {
+      mapped[component_type] = components_[component_type]->MapTo(directory);
+      mapped_ |= mapped[component_type];
+    }
+    // Only a world stored in files as a whole can be restored.
+    if (config.state.has_value() &&
+        std::ranges::all_of(mapped, std::identity{})) {
+      assert(config.shared.empty() && "Shared components can't be restored");
+      state_ = std::move(config.state);
+    }
+    bool restored = state_.has_value() && std::filesystem::exists(*state_);
+    if (restored) {
+      RestoreState();
+    }
+    for (const ComponentPoolRef &pool : components_) {
+      pool->Reopen(restored ? archetypes_.Size() : 0);
+    }
+    if (restored) {
+      CheckRestored();
+    }
+    for (const auto &[resource_type, make_resource] : config.resources) {
+      if (owned_resources_.size() <= resource_type) {
+        owned_resources_.resize(resource_type + 1);
+      }
+      owned_resources_[resource_type] = make_resource();
+      SetResource(resource_type, owned_resources_[resource_type].get());
+    }
+    if (config.trace.has_value()) {
+      trace_ = std::make_unique<TraceWriter>(*config.trace,
+                                             config.component_sizes);
+    }
+    if (config.rollback_depth != 0) {
+      clock_.depth = config.rollback_depth;
+      entities_.Journal(&clock_);
+      hierarchy_.Journal(&clock_);
+      for (const ComponentPoolRef &pool : components_) {
+        pool->Journal(&clock_);
+      }
+    }
+  }
+
+  // A world stored in files is synced once more, so that it can be restored.
+  // Errors can't be reported here, and the next build of the world rejects
+  // the files left out of sync.
+  ~WorldImpl() override {
+    if (state_.has_value()) {
+      try {
+        Sync();
+      } catch (const std::exception &) {
+      }
+    }
+  }
 
  protected:
   Entity Add() override {
     Entity entity = entities_.Add();
-    EntityData<N> &entity_data = entities_[entity];
-    entity_data.Link(Entity::TypeID());
-    std::size_t handle =
-        components_[Entity::TypeID()]->Add(entity_data.archetype());
-    entity_data.component_handle(handle);
-    static_cast<Entity &>(components_[Entity::TypeID()]->Get(
-        entity_data.archetype(), handle)) = entity;
+    Materialize(entity);
+    if (trace_ != nullptr) {
+      trace_->AddEntity(entity);
+    }
     return entity;
   }
 
-  void Remove(Entity entity) override {
-    const Archetype<N> &archetype = entities_[entity].archetype();
-    std::size_t handle = entities_[entity].component_handle();
-    for (auto [has, pool] : std::views::zip(archetype, components_)) {
-      if (has) {
-        pool->Remove(archetype, handle);
+  Entity AddPrefab() override {
+    Entity prefab = entities_.Add();
+    Materialize(prefab, ArchetypeRegistry<N>::kEmptyPrefab);
+    return prefab;
+  }
+
+  std::vector<Entity> Instantiate(Entity prefab, std::size_t count) override {
+    const EntityData &prefab_data = std::as_const(entities_)[prefab];
+    std::size_t prefab_archetype = prefab_data.archetype();
+    std::size_t prefab_handle = prefab_data.component_handle();
+    assert(archetypes_[prefab_archetype].prefab && "Entity isn't a prefab");
+    std::size_t archetype =
+        archetypes_.Intern(archetypes_[prefab_archetype].signature, false, 0,
+                           archetypes_[prefab_archetype].shared);
+    MarkUnsorted(archetype);
+    std::vector<Entity> result;
+    result.reserve(count);
+    for (std::size_t idx = 0; idx < count; ++idx) {
+      result.push_back(entities_.Add());
+    }
+    // Every column of the archetype takes the same rows, so the handles of
+    // the entity column are the handles of the others too.
+    std::vector<std::size_t> handles;
+    handles.reserve(count);
+    DataPool<Entity> &entity_column = EntityComponents().Storage(archetype);
+    entity_column.Fill(Entity{}, count, &handles);
+    for (auto [entity, handle] : std::views::zip(result, handles)) {
+      entity_column[handle] = entity;
+      entities_[entity].archetype(archetype);
+      entities_[entity].component_handle(handle);
+    }
+    for (std::size_t component_type : archetypes_[archetype].components) {
+      if (component_type == Entity::TypeID()) {
+        continue;
+      }
+      const ComponentBase &value =
+          components_[component_type]->Get(prefab_archetype, prefab_handle);
+      components_[component_type]->Fill(archetype, value, count);
+      for (const ComponentTrackerRef &tracker : trackers_[component_type]) {
+        for (Entity entity : result) {
+          tracker->NotifyAdd(entity, value);
+        }
+      }
+      for (Entity entity : result) {
+        Record(Change::kAdd, component_type, ChangeLog::kNone, archetype,
+               entity);
+      }
+    }
+    return result;
+  }
+
+  Entity ReserveEntity() override { return entities_.Reserve(); }
+
+  std::vector<Entity> ReserveEntities(std::size_t count) override {
+    return entities_.Reserve(count);
+  }
+
+  void Flush() override {
+    entities_.Flush([this](Entity entity) {
+      Materialize(entity);
+      if (trace_ != nullptr) {
+        trace_->AddEntity(entity);
       }
+    });
+  }
+
+  void Remove(Entity entity) override {
+    if (trace_ != nullptr) {
+      trace_->RemoveEntity(entity);
     }
+    const EntityData &entity_data = std::as_const(entities_)[entity];
+    std::size_t archetype = entity_data.archetype();
+    std::size_t handle = entity_data.component_handle();
+    for (std::size_t component_type : archetypes_[archetype].components) {
+      NotifyRemove(trackers_[component_type], entity);
+      Record(Change::kRemove, component_type, archetype, ChangeLog::kNone,
+             entity);
+      components_[component_type]->Remove(archetype, handle);
+    }
+    hierarchy_.Erase(entity);
     entities_.Remove(entity);
   }
 
   bool Alive(Entity entity) const override { return entities_.Alive(entity); }
 
+  std::vector<Entity> Migrate(std::span<const Entity> entities,
+                              World &destination) override {
+    assert(dynamic_cast<WorldImpl<N> *>(&destination) != nullptr &&
+           "Worlds must have the same components");
+    assert(&destination != this && "Migrating into the same world");
+    auto &dst = static_cast<WorldImpl<N> &>(destination);
+    // Entities of an archetype move together, keeping their input positions.
+    std::map<std::size_t, std::vector<std::size_t>> positions;
+    for (std::size_t idx = 0; idx < entities.size(); ++idx) {
+      positions[std::as_const(entities_)[entities[idx]].archetype()]
+          .push_back(idx);
+    }
+    std::vector<Entity> result(entities.size());
+    std::vector<std::size_t> handles;
+    std::vector<std::size_t> new_handles;
+    for (const auto &[archetype, indices] : positions) {
+      const std::vector<std::size_t> &components =
+          archetypes_[archetype].components;
+      // Archetype ids and shared value ids are local to a world.
+      typename ArchetypeRegistry<N>::SharedValues shared =
+          archetypes_[archetype].shared;
+      for (auto &[component_type, value] : shared) {
+        value = dst.shared_[component_type]->Intern(
+            shared_[component_type]->Get(value));
+      }
+      std::size_t dst_archetype = dst.archetypes_.Intern(
+          archetypes_[archetype].signature, archetypes_[archetype].prefab, 0,
+          std::move(shared));
+      dst.MarkUnsorted(dst_archetype);
+      handles.clear();
+      for (std::size_t idx : indices) {
+        handles.push_back(
+            std::as_const(entities_)[entities[idx]].component_handle());
+      }
+      new_handles.clear();
+      for (std::size_t component_type : components) {
+        components_[component_type]->MoveRows(
+            archetype, handles, *dst.components_[component_type],
+            dst_archetype,
+            component_type == Entity::TypeID() ? &new_handles : nullptr);
+      }
+      DataPool<Entity> &moved_rows =
+          dst.EntityComponents().Storage(dst_archetype);
+      for (auto [idx, new_handle] : std::views::zip(indices, new_handles)) {
+        Entity moved = dst.entities_.Add();
+        EntityData &moved_data = dst.entities_[moved];
+        moved_data.archetype(dst_archetype);
+        moved_data.component_handle(new_handle);
+        moved_rows[new_handle] = moved;
+        result[idx] = moved;
+      }
+      for (std::size_t component_type : components) {
+        for (auto [idx, new_handle] : std::views::zip(indices, new_handles)) {
+          const ComponentBase &component =
+              dst.components_[component_type]->Get(dst_archetype, new_handle);
+          for (const ComponentTrackerRef &tracker :
+               dst.trackers_[component_type]) {
+            tracker->NotifyAdd(result[idx], component);
+          }
+          dst.Record(Change::kAdd, component_type, ChangeLog::kNone,
+                     dst_archetype, result[idx]);
+          NotifyRemove(trackers_[component_type], entities[idx]);
+          Record(Change::kRemove, component_type, archetype, ChangeLog::kNone,
+                 entities[idx]);
+        }
+      }
+      for (std::size_t idx : indices) {
+        if (trace_ != nullptr) {
+          trace_->RemoveEntity(entities[idx]);
+        }
+        hierarchy_.Erase(entities[idx]);
+        entities_.Remove(entities[idx]);
+      }
+    }
+    return result;
+  }
+
+  Region AddRegion() override {
+    if (free_regions_.empty()) {
+      return Region{next_region_++};
+    }
+    Region region{free_regions_.back()};
+    free_regions_.pop_back();
+    return region;
+  }
+
+  Entity Add(Region region) override {
+    Entity entity = entities_.Add();
+    Materialize(entity, archetypes_.Intern(Archetype<N>{}, false, region.id()));
+    if (trace_ != nullptr) {
+      trace_->AddEntity(entity);
+    }
+    return entity;
+  }
+
+  void SaveRegion(Region region,
+                  const std::filesystem::path &path) const override {
+    assert(region.id() != 0 && "Not a region");
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file) {
+      throw std::runtime_error("Can't open region " + path.string());
+    }
+    file.write(kRegionMagic.data(), kRegionMagic.size());
+    const auto &entity_components =
+        static_cast<const ComponentPool<Entity> &>(
+            *components_[Entity::TypeID()]);
+    // Archetypes the region entities left behind are skipped.
+    std::vector<std::pair<std::size_t, std::size_t>> tables;
+    for (std::size_t archetype : archetypes_.Region(region.id())) {
+      const DataPool<Entity> *rows = entity_components.Find(archetype);
+      std::size_t size =
+          rows == nullptr ? 0 : std::ranges::distance(*rows);
+      if (size != 0) {
+        tables.emplace_back(archetype, size);
+      }
+    }
+    WriteVarint(file, tables.size());
+    for (auto [archetype, size] : tables) {
+      const std::vector<std::size_t> &components =
+          archetypes_[archetype].components;
+      WriteVarint(file, size);
+      WriteVarint(file, components.size() - 1);
+      for (std::size_t component_type : components) {
+        if (component_type == Entity::TypeID()) {
+          continue;
+        }
+        WriteVarint(file, component_type);
+        components_[component_type]->Save(archetype, file);
+      }
+      WriteVarint(file, archetypes_[archetype].shared.size());
+      for (auto [component_type, value] : archetypes_[archetype].shared) {
+        WriteVarint(file, component_type);
+        shared_[component_type]->Save(value, file);
+      }
+    }
+    if (!file) {
+      throw std::runtime_error("Can't write region " + path.string());
+    }
+  }
+
+  RegionChunk PrepareRegion(const std::filesystem::path &path) const override {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+      throw std::runtime_error("Can't open region " + path.string());
+    }
+    std::array<char, kRegionMagic.size()> magic{};
+    file.read(magic.data(), magic.size());
+    if (!file || magic != kRegionMagic) {
+      throw std::runtime_error("Not a region " + path.string());
+    }
+    RegionChunk chunk;
+    chunk.tables_.resize(ReadVarint(file));
+    for (RegionChunk::Table &table : chunk.tables_) {
+      table.size = ReadVarint(file);
+      // Ids are given to the entities by LoadRegion.
+      auto entities = std::make_unique<RegionColumn<Entity>>();
+      entities->rows.Fill(Entity{}, table.size);
+      table.components.push_back(Entity::TypeID());
+      table.columns.push_back(std::move(entities));
+      std::size_t num_components = ReadVarint(file);
+      for (std::size_t idx = 0; idx < num_components; ++idx) {
+        std::size_t component_type = ReadVarint(file);
+        if (component_type >= N || component_type <= table.components.back()) {
+          throw std::runtime_error("Malformed region " + path.string());
+        }
+        table.components.push_back(component_type);
+        table.columns.push_back(
+            components_[component_type]->Load(file, table.size));
+      }
+      std::size_t num_shared = ReadVarint(file);
+      for (std::size_t idx = 0; idx < num_shared; ++idx) {
+        std::size_t component_type = ReadVarint(file);
+        if (component_type >= N || shared_[component_type] == nullptr ||
+            (!table.shared.empty() &&
+             component_type <= table.shared.back().first)) {
+          throw std::runtime_error("Malformed region " + path.string());
+        }
+        table.shared.emplace_back(component_type,
+                                  components_[component_type]->Load(file, 1));
+      }
+    }
+    return chunk;
+  }
+
+  Region LoadRegion(RegionChunk chunk) override {
+    Region region = AddRegion();
+    for (RegionChunk::Table &table : chunk.tables_) {
+      Archetype<N> signature = MakeFilter(table.components);
+      typename ArchetypeRegistry<N>::SharedValues shared;
+      for (auto &[component_type, column] : table.shared) {
+        signature.Set(component_type);
+        shared.emplace_back(component_type,
+                            shared_[component_type]->Adopt(*column));
+      }
+      std::size_t archetype =
+          archetypes_.Intern(signature, false, region.id(), std::move(shared));
+      MarkUnsorted(archetype);
+      for (auto [component_type, column] :
+           std::views::zip(table.components, table.columns)) {
+        components_[component_type]->Adopt(archetype, *column);
+      }
+      DataPool<Entity> &entity_column = EntityComponents().Storage(archetype);
+      std::vector<Entity> loaded;
+      loaded.reserve(table.size);
+      for (std::size_t handle = 0; handle < table.size; ++handle) {
+        Entity entity = entities_.Add();
+        entity_column[handle] = entity;
+        entities_[entity].archetype(archetype);
+        entities_[entity].component_handle(handle);
+        loaded.push_back(entity);
+      }
+      for (std::size_t component_type : table.components) {
+        if (component_type == Entity::TypeID() ||
+            (trackers_[component_type].empty() &&
+             observers_[component_type].empty())) {
+          continue;
+        }
+        for (std::size_t handle = 0; handle < loaded.size(); ++handle) {
+          const ComponentBase &component =
+              components_[component_type]->Get(archetype, handle);
+          for (const ComponentTrackerRef &tracker :
+               trackers_[component_type]) {
+            tracker->NotifyAdd(loaded[handle], component);
+          }
+          Record(Change::kAdd, component_type, ChangeLog::kNone, archetype,
+                 loaded[handle]);
+        }
+      }
+    }
+    return region;
+  }
+
+  void UnloadRegion(Region region) override {
+    assert(region.id() != 0 && "Not a region");
+    for (std::size_t archetype : archetypes_.Region(region.id())) {
+      Drop(archetype);
+    }
+    free_regions_.push_back(region.id());
+  }
+
+  std::uint64_t Fork() override {
+    assert(clock_.depth != 0 &&
+           "Forks are disabled, see WorldBuilder::Rollback");
+    ++clock_.fork;
+    ++clock_.stamp;
+    if (forks_.size() == clock_.depth) {
+      forks_.pop_front();
+    }
+    forks_.push_back(ForkState{.fork = clock_.fork,
+                               .next_region = next_region_,
+                               .free_regions = free_regions_});
+    return clock_.fork;
+  }
+
+  void Rollback(std::uint64_t fork) override {
+    assert(fork != 0 && fork >= clock_.Oldest() && fork <= clock_.fork &&
+           "Fork isn't kept");
+    entities_.Rollback(fork);
+    hierarchy_.Rollback(fork);
+    for (const ComponentPoolRef &pool : components_) {
+      pool->Rollback(fork);
+    }
+    while (forks_.back().fork > fork) {
+      forks_.pop_back();
+    }
+    const ForkState &state = forks_.back();
+    next_region_ = state.next_region;
+    free_regions_ = state.free_regions;
+    clock_.fork = fork;
+    ++clock_.stamp;
+  }
+
+  void SetParent(Entity child, Entity parent) override {
+    assert(entities_.Alive(child) && entities_.Alive(parent) &&
+           "Linking dead entities");
+    hierarchy_.Link(child, parent);
+  }
+
+  void RemoveParent(Entity child) override { hierarchy_.Unlink(child); }
+
+  Entity Parent(Entity child) const override {
+    return hierarchy_.Parent(child);
+  }
+
+  std::span<const Entity> Children(Entity parent) const override {
+    return hierarchy_.Children(parent);
+  }
+
+  std::span<const HierarchyNode> Hierarchy() override {
+    return hierarchy_.Traverse();
+  }
+
   void Add(Entity entity, std::size_t component_type) override {
-    EntityData<N> &entity_data = entities_[entity];
+    if (trace_ != nullptr) {
+      trace_->AddComponent(entity, component_type);
+    }
+    EntityData &entity_data = entities_[entity];
     std::size_t handle = entity_data.component_handle();
-    if (entity_data.Has(component_type)) {
+    std::size_t old_archetype = entity_data.archetype();
+    std::size_t archetype = old_archetype;
+    for (std::size_t part : parts_[component_type]) {
+      archetype = archetypes_.With(archetype, part);
+    }
+    if (archetype == old_archetype) {
       return;
     }
-    Archetype<N> old_archetype = entity_data.archetype();
-    entity_data.Link(component_type);
-    const Archetype<N> &archetype = entity_data.archetype();
-    for (auto [has, pool] : std::views::zip(old_archetype, components_)) {
-      if (has) {
-        pool->Move(old_archetype, handle, archetype);
+    entity_data.archetype(archetype);
+    MarkUnsorted(archetype);
+    // Every column takes the same row, so any of them gives the handle.
+    std::size_t new_handle = 0;
+    for (std::size_t moved_type : archetypes_[old_archetype].components) {
+      new_handle =
+          components_[moved_type]->Move(old_archetype, handle, archetype);
+    }
+    for (std::size_t part : parts_[component_type]) {
+      if (!archetypes_.Has(old_archetype, part) && shared_[part] == nullptr) {
+        new_handle = components_[part]->Add(archetype);
       }
     }
-    std::size_t new_handle = components_[component_type]->Add(archetype);
     entity_data.component_handle(new_handle);
+    for (std::size_t part : parts_[component_type]) {
+      if (archetypes_.Has(old_archetype, part)) {
+        continue;
+      }
+      for (const ComponentTrackerRef &tracker : trackers_[part]) {
+        tracker->NotifyAdd(entity,
+                           components_[part]->Get(archetype, new_handle));
+      }
+      Record(Change::kAdd, part, old_archetype, archetype, entity);
+    }
   }
 
   void Remove(Entity entity, std::size_t component_type) override {
-    EntityData<N> &entity_data = entities_[entity];
+    if (trace_ != nullptr) {
+      trace_->RemoveComponent(entity, component_type);
+    }
+    EntityData &entity_data = entities_[entity];
     std::size_t handle = entity_data.component_handle();
-    if (!entity_data.Has(component_type)) {
+    std::size_t old_archetype = entity_data.archetype();
+    std::size_t archetype = old_archetype;
+    for (std::size_t part : parts_[component_type]) {
+      archetype = archetypes_.Without(archetype, part);
+    }
+    if (archetype == old_archetype) {
       return;
     }
-    Archetype<N> old_archetype = entity_data.archetype();
-    entity_data.Unlink(component_type);
-    const Archetype<N> &archetype = entity_data.archetype();
-    components_[component_type]->Remove(archetype,
-                                        entity_data.component_handle());
-    std::size_t new_handle = 0;
-    for (auto [has, pool] : std::views::zip(old_archetype, components_)) {
-      if (has) {
-        new_handle = pool->Move(old_archetype, handle, archetype);
+    for (std::size_t part : parts_[component_type]) {
+      if (!archetypes_.Has(old_archetype, part)) {
+        continue;
       }
+      NotifyRemove(trackers_[part], entity);
+      Record(Change::kRemove, part, old_archetype, archetype, entity);
+      components_[part]->Remove(old_archetype, handle);
+    }
+    entity_data.archetype(archetype);
+    MarkUnsorted(archetype);
+    std::size_t new_handle = 0;
+    for (std::size_t moved_type : archetypes_[archetype].components) {
+      new_handle =
+          components_[moved_type]->Move(old_archetype, handle, archetype);
     }
     entity_data.component_handle(new_handle);
   }
 
   ComponentBase &Get(Entity entity, std::size_t component_type) override {
-    EntityData<N> &entity_data = entities_[entity];
+    if (trace_ != nullptr) {
+      trace_->GetComponent(entity, component_type);
+    }
+    assert(shared_[component_type] == nullptr &&
+           "Shared components are read with GetShared");
+    const EntityData &entity_data = std::as_const(entities_)[entity];
     return components_[component_type]->Get(entity_data.archetype(),
                                             entity_data.component_handle());
   }
 
   const ComponentBase &Get(Entity entity,
                            std::size_t component_type) const override {
-    const EntityData<N> &entity_data = entities_[entity];
+    if (trace_ != nullptr) {
+      trace_->GetComponent(entity, component_type);
+    }
+    assert(shared_[component_type] == nullptr &&
+           "Shared components are read with GetShared");
+    const EntityData &entity_data = entities_[entity];
     return components_[component_type]->Get(entity_data.archetype(),
                                             entity_data.component_handle());
   }
 
+  Row Locate(Entity entity, std::span<std::size_t> component_ids) override {
+    assert(entities_.Alive(entity) && "Getting a dead entity");
+    if (trace_ != nullptr) {
+      for (std::size_t component_type : component_ids) {
+        trace_->GetComponent(entity, component_type);
+      }
+    }
+    const EntityData &entity_data = std::as_const(entities_)[entity];
+    return Row{.columns = Columns(entity_data.archetype(), component_ids),
+               .handle = entity_data.component_handle(),
+               .index = 0};
+  }
+
+  void LocateMany(std::span<const Entity> entities,
+                  std::span<std::size_t> component_ids,
+                  std::vector<Row> &rows) override {
+    // Archetypes, handles and positions of the entities.
+    std::vector<std::array<std::size_t, 3>> located;
+    located.reserve(entities.size());
+    for (std::size_t idx = 0; idx < entities.size(); ++idx) {
+      assert(entities_.Alive(entities[idx]) && "Getting a dead entity");
+      if (trace_ != nullptr) {
+        for (std::size_t component_type : component_ids) {
+          trace_->GetComponent(entities[idx], component_type);
+        }
+      }
+      const EntityData &entity_data = std::as_const(entities_)[entities[idx]];
+      located.push_back(
+          {entity_data.archetype(), entity_data.component_handle(), idx});
+    }
+    std::ranges::sort(located);
+    rows.clear();
+    rows.reserve(located.size());
+    void *const *columns = nullptr;
+    for (std::size_t idx = 0; idx < located.size(); ++idx) {
+      auto [archetype, handle, position] = located[idx];
+      if (idx == 0 || archetype != located[idx - 1][0]) {
+        columns = Columns(archetype, component_ids);
+      }
+      rows.push_back(
+          Row{.columns = columns, .handle = handle, .index = position});
+    }
+  }
+
+  void SetEnabled(Entity entity, std::size_t component_type,
+                  bool enabled) override {
+    assert(Has(entity, component_type) && "Entity lacks the component");
+    assert(shared_[component_type] == nullptr &&
+           "Shared components can't be disabled");
+    const EntityData &entity_data = std::as_const(entities_)[entity];
+    for (std::size_t part : parts_[component_type]) {
+      components_[part]->SetEnabled(entity_data.archetype(),
+                                    entity_data.component_handle(), enabled);
+    }
+  }
+
+  bool Enabled(Entity entity, std::size_t component_type) const override {
+    const EntityData &entity_data = entities_[entity];
+    return components_[component_type]->Enabled(
+        entity_data.archetype(), entity_data.component_handle());
+  }
+
+  void SetShared(Entity entity, std::size_t component_type,
+                 const ComponentBase &value) override {
+    assert(shared_[component_type] != nullptr && "Component isn't shared");
+    EntityData &entity_data = entities_[entity];
+    std::size_t old_archetype = entity_data.archetype();
+    std::size_t archetype = archetypes_.Share(
+        old_archetype, component_type, shared_[component_type]->Intern(value));
+    if (archetype == old_archetype) {
+      return;
+    }
+    std::size_t handle = entity_data.component_handle();
+    std::size_t new_handle = 0;
+    for (std::size_t moved_type : archetypes_[old_archetype].components) {
+      new_handle =
+          components_[moved_type]->Move(old_archetype, handle, archetype);
+    }
+    entity_data.archetype(archetype);
+    entity_data.component_handle(new_handle);
+    MarkUnsorted(archetype);
+  }
+
+  const ComponentBase &GetShared(Entity entity,
+                                 std::size_t component_type) const override {
+    assert(shared_[component_type] != nullptr && "Component isn't shared");
+    return shared_[component_type]->Get(archetypes_.SharedValue(
+        entities_[entity].archetype(), component_type));
+  }
+
+  void Modified(Entity entity, std::size_t component_type) override {
+    std::size_t archetype = std::as_const(entities_)[entity].archetype();
+    if (std::ranges::find(sort_keys_, component_type, &SortKey::first) !=
+        sort_keys_.end()) {
+      MarkUnsorted(archetype);
+    }
+    Record(Change::kSet, component_type, archetype, archetype, entity);
+    if (trackers_[component_type].empty()) {
+      return;
+    }
+    const ComponentBase &component = Get(entity, component_type);
+    for (const ComponentTrackerRef &tracker : trackers_[component_type]) {
+      tracker->NotifySet(entity, component);
+    }
+  }
+
   bool Has(Entity entity, std::size_t component_type) const override {
     if (!entities_.Alive(entity)) {
       return false;
     }
-    return entities_[entity].Has(component_type);
+    return archetypes_.Has(entities_[entity].archetype(), component_type);
+  }
+
+  void RemoveAll(std::span<std::size_t> component_ids) override {
+    for (std::size_t archetype : Match(component_ids).archetypes) {
+      Drop(archetype);
+    }
   }
 
-  std::span<internal::ComponentBase *> QueryOne(
+  void AddToAll(std::size_t component_type,
+                std::span<std::size_t> component_ids) override {
+    // Moved rows join archetypes matching the filter, so the cache grows.
+    std::vector<std::size_t> matched = Match(component_ids).archetypes;
+    for (std::size_t archetype : matched) {
+      std::size_t target = archetype;
+      for (std::size_t part : parts_[component_type]) {
+        target = archetypes_.With(target, part);
+      }
+      if (target == archetype) {
+        continue;
+      }
+      std::vector<Entity> moved = MoveRows(archetype, target);
+      for (std::size_t part : parts_[component_type]) {
+        if (archetypes_.Has(archetype, part)) {
+          continue;
+        }
+        if (shared_[part] == nullptr) {
+          components_[part]->Fill(target, moved.size());
+        }
+        if (trackers_[part].empty() && observers_[part].empty()) {
+          continue;
+        }
+        for (Entity entity : moved) {
+          const ComponentBase &component = components_[part]->Get(
+              target, std::as_const(entities_)[entity].component_handle());
+          for (const ComponentTrackerRef &tracker : trackers_[part]) {
+            tracker->NotifyAdd(entity, component);
+          }
+          Record(Change::kAdd, part, archetype, target, entity);
+        }
+      }
+    }
+  }
+
+  void RemoveFromAll(std::size_t component_type,
+                     std::span<std::size_t> component_ids) override {
+    std::vector<std::size_t> filter(component_ids.begin(),
+                                    component_ids.end());
+    filter.push_back(component_type);
+    std::vector<std::size_t> matched = Match(filter).archetypes;
+    for (std::size_t archetype : matched) {
+      DataPool<Entity> *entities = EntityComponents().Find(archetype);
+      if (entities == nullptr) {
+        continue;
+      }
+      std::size_t target = archetype;
+      for (std::size_t part : parts_[component_type]) {
+        target = archetypes_.Without(target, part);
+      }
+      for (std::size_t part : parts_[component_type]) {
+        if (!archetypes_.Has(archetype, part)) {
+          continue;
+        }
+        if (!trackers_[part].empty() || !observers_[part].empty()) {
+          for (Entity entity : std::as_const(*entities)) {
+            NotifyRemove(trackers_[part], entity);
+            Record(Change::kRemove, part, archetype, target, entity);
+          }
+        }
+        components_[part]->Clear(archetype);
+      }
+      MoveRows(archetype, target);
+    }
+  }
+
+  std::span<void *const> QueryOne(
       std::size_t component_type,
       std::span<std::size_t> component_ids) override {
-    Archetype<N> archetype;
-    for (std::size_t component_id : component_ids) {
-      archetype.Set(component_id);
+    // World::Query asks for the columns in the order of the components, so
+    // the first one starts a new query.
+    if (trace_ != nullptr && component_type == component_ids.front()) {
+      trace_->Query(component_ids);
+    }
+    assert(shared_[component_type] == nullptr &&
+           "Shared components are queried with QueryShared");
+    return Column(component_type, Match(component_ids));
+  }
+
+  std::span<const SharedGroup> QueryGroups(
+      std::span<std::size_t> component_ids) override {
+    std::size_t shared_type = component_ids.front();
+    assert(shared_[shared_type] != nullptr && "Component isn't shared");
+    const std::vector<std::size_t> &matched = Match(component_ids).archetypes;
+    GroupCache &cache =
+        groups_[std::vector<std::size_t>(component_ids.begin(),
+                                         component_ids.end())];
+    for (; cache.scanned < matched.size(); ++cache.scanned) {
+      std::size_t archetype = matched[cache.scanned];
+      std::size_t value = archetypes_.SharedValue(archetype, shared_type);
+      auto [it, inserted] = cache.by_value.try_emplace(value,
+                                                       cache.groups.size());
+      if (inserted) {
+        cache.groups.push_back(SharedGroup{
+            .value = &shared_[shared_type]->Get(value),
+            .columns = std::vector<std::vector<void *>>(
+                component_ids.size() - 1)});
+      }
+      SharedGroup &group = cache.groups[it->second];
+      for (std::size_t idx = 1; idx < component_ids.size(); ++idx) {
+        group.columns[idx - 1].push_back(
+            components_[component_ids[idx]]->Column(archetype));
+      }
     }
-    return components_[component_type]->Query(archetype);
+    return cache.groups;
+  }
+
+  void Sort() override {
+    for (std::size_t archetype : unsorted_) {
+      auto key = std::ranges::find_if(sort_keys_, [&](const SortKey &key) {
+        return archetypes_.Has(archetype, key.first);
+      });
+      DataPool<Entity> *entities = EntityComponents().Find(archetype);
+      if (key == sort_keys_.end() || entities == nullptr) {
+        continue;
+      }
+      std::vector<std::size_t> handles =
+          components_[key->first]->Sort(archetype, key->second);
+      for (std::size_t component_type : archetypes_[archetype].components) {
+        components_[component_type]->Permute(archetype, handles);
+      }
+      std::size_t handle = 0;
+      for (Entity entity : std::as_const(*entities)) {
+        entities_[entity].component_handle(handle++);
+      }
+    }
+    unsorted_.clear();
   }
 
   void Update() override {
-    for (const SystemFunctionType &system : systems_) {
-      system(*this);
+    auto now = std::chrono::steady_clock::now();
+    Duration delta_time{};
+    if (last_update_.has_value()) {
+      delta_time = std::chrono::duration_cast<Duration>(now - *last_update_);
+    }
+    last_update_ = now;
+    Update(delta_time);
+  }
+
+  void Sync() override {
+    for (const ComponentPoolRef &pool : components_) {
+      pool->Sync();
+    }
+    if (state_.has_value()) {
+      SaveState();
     }
   }
 
+  void Notify() override {
+    for (std::size_t component_type : observed_) {
+      // Changes made by the observers are delivered by the next call.
+      std::swap(changes_[component_type], delivering_[component_type]);
+      delivering_[component_type].Visit(
+          [&](Change change, std::span<const Entity> entities) {
+            for (const ComponentObserverRef &observer :
+                 observers_[component_type]) {
+              switch (change) {
+                case Change::kAdd:
+                  observer->NotifyAdd(*this, entities);
+                  break;
+                case Change::kSet:
+                  observer->NotifySet(*this, entities);
+                  break;
+                case Change::kRemove:
+                  observer->NotifyRemove(*this, entities);
+                  break;
+              }
+            }
+          });
+      delivering_[component_type].Clear();
+    }
+  }
+
+  void Update(Duration delta_time) override {
+    Flush();
+    Notify();
+    for (const EventChannelRef &channel : channels_) {
+      if (channel != nullptr) {
+        channel->Swap();
+      }
+    }
+    Sort();
+    scheduler_.Run(*this, delta_time);
+    Publish();
+  }
+
+  Duration DeltaTime() const override { return scheduler_.delta_time(); }
+
+  const SnapshotBufferBase &Snapshots(
+      std::size_t component_type) const override {
+    assert(snapshots_[component_type] != nullptr && "Unknown snapshot");
+    return *snapshots_[component_type];
+  }
+
+  EventChannelBase &Channel(std::size_t event_type) override {
+    assert(event_type < channels_.size() && channels_[event_type] != nullptr &&
+           "Unknown event type");
+    return *channels_[event_type];
+  }
+
  private:
-  EntityPool<N> entities_{};
-  std::array<std::unique_ptr<ComponentPoolBase<N>>, N> components_;
-  std::vector<SystemFunctionType> systems_;
+  using SortKey = std::pair<std::size_t, ComponentLess>;
+
+  // State of the world besides the storages as of a fork, see Fork.
+  struct ForkState {
+    std::uint64_t fork;
+    std::size_t next_region;
+    std::vector<std::size_t> free_regions;
+  };
+
+  // Archetypes matching a filter and their storages, see QueryOne. Archetypes
+  // are never unregistered and storages never move, so the cache only grows.
+  struct QueryCache {
+    std::vector<std::size_t> archetypes;
+    // Number of registered archetypes already checked against the filter.
+    std::size_t scanned{0};
+    std::unordered_map<std::size_t, std::vector<void *>> columns;
+  };
+
+  // Groups of the archetypes matching a query by the value of its shared
+  // component, see QueryGroups. Grows like QueryCache.
+  struct GroupCache {
+    std::vector<SharedGroup> groups;
+    // Indices of the groups by the ids of their values.
+    std::unordered_map<std::size_t, std::size_t> by_value;
+    // Number of matched archetypes already grouped.
+    std::size_t scanned{0};
+  };
+
+  ComponentPool<Entity> &EntityComponents() {
+    return static_cast<ComponentPool<Entity> &>(*components_[Entity::TypeID()]);
+  }
+
+  // Returns the regular archetypes having all the components in registration
+  // order.
+  QueryCache &Match(std::span<std::size_t> component_ids) {
+    Archetype<N> filter = MakeFilter(component_ids);
+    QueryCache &cache = queries_[filter];
+    for (; cache.scanned < archetypes_.Size(); ++cache.scanned) {
+      const auto &record = archetypes_[cache.scanned];
+      if (!record.prefab && filter.IsPrefix(record.signature)) {
+        cache.archetypes.push_back(cache.scanned);
+      }
+    }
+    return cache;
+  }
+
+  // Returns the storages of the archetype indexed by component type with the
+  // given ones set, see Row. Storages never move, so they're cached.
+  void *const *Columns(std::size_t archetype,
+                       std::span<const std::size_t> component_ids) {
+    if (located_.size() <= archetype) {
+      located_.resize(archetypes_.Size());
+    }
+    std::vector<void *> &columns = located_[archetype];
+    if (columns.empty()) {
+      columns.resize(N);
+    }
+    for (std::size_t component_type : component_ids) {
+      if (columns[component_type] == nullptr) {
+        assert(archetypes_.Has(archetype, component_type) &&
+               shared_[component_type] == nullptr &&
+               "Entity lacks the component");
+        columns[component_type] =
+            components_[component_type]->Column(archetype);
+      }
+    }
+    return columns.data();
+  }
+
+  // Returns the storages of the component in the archetypes of the cache
+  // extending them to the archetypes matched since the previous call.
+  std::span<void *const> Column(std::size_t component_type,
+                                QueryCache &cache) {
+    std::vector<void *> &column = cache.columns[component_type];
+    for (std::size_t idx = column.size(); idx < cache.archetypes.size();
+         ++idx) {
+      column.push_back(components_[component_type]->Column(
+          cache.archetypes[idx]));
+    }
+    return column;
+  }
+
+  // Remove all the entities of the archetype at once.
+  void Drop(std::size_t archetype) {
+    DataPool<Entity> *entities = EntityComponents().Find(archetype);
+    if (entities == nullptr) {
+      return;
+    }
+    const std::vector<std::size_t> &components =
+        archetypes_[archetype].components;
+    for (std::size_t component_type : components) {
+      if (trackers_[component_type].empty() &&
+          observers_[component_type].empty()) {
+        continue;
+      }
+      for (Entity entity : std::as_const(*entities)) {
+        NotifyRemove(trackers_[component_type], entity);
+        Record(Change::kRemove, component_type, archetype, ChangeLog::kNone,
+               entity);
+      }
+    }
+    for (Entity entity : std::as_const(*entities)) {
+      hierarchy_.Erase(entity);
+      entities_.Remove(entity);
+    }
+    for (std::size_t component_type : components) {
+      components_[component_type]->Clear(archetype);
+    }
+  }
+
+  // Move all the rows of the archetype to the target one, which has a subset
+  // or a superset of its components. Returns the moved entities.
+  std::vector<Entity> MoveRows(std::size_t archetype, std::size_t target) {
+    DataPool<Entity> *rows = EntityComponents().Find(archetype);
+    if (rows == nullptr || rows->begin() == rows->end()) {
+      return {};
+    }
+    DataPool<Entity> *target_rows = EntityComponents().Find(target);
+    bool empty_target =
+        target_rows == nullptr || target_rows->begin() == target_rows->end();
+    if (empty_target) {
+      // Forget the slots freed in the target, so that its columns, including
+      // the ones added afterwards, take slots from the start.
+      for (std::size_t component_type : archetypes_[target].components) {
+        components_[component_type]->Clear(target);
+      }
+    }
+    // Swapping keeps the gaps between rows, which new columns can't
+    // reproduce. Files are named after the archetypes and journals stay with
+    // the storages, so they stay put.
+    bool swap =
+        !mapped_ && clock_.depth == 0 && empty_target && rows->Dense();
+    std::vector<std::size_t> handles;
+    for (std::size_t component_type : archetypes_[archetype].components) {
+      if (archetypes_.Has(target, component_type)) {
+        components_[component_type]->MoveAll(
+            archetype, target, swap,
+            component_type == Entity::TypeID() ? &handles : nullptr);
+      }
+    }
+    DataPool<Entity> &moved_rows = EntityComponents().Storage(target);
+    if (swap) {
+      handles = moved_rows.Indices();
+    }
+    std::vector<Entity> moved;
+    moved.reserve(handles.size());
+    for (std::size_t handle : handles) {
+      Entity entity = moved_rows[handle];
+      entities_[entity].archetype(target);
+      entities_[entity].component_handle(handle);
+      moved.push_back(entity);
+    }
+    MarkUnsorted(target);
+    return moved;
+  }
+
+  // Store the entity component of a new entity.
+  void Materialize(Entity entity,
+                   std::size_t empty = ArchetypeRegistry<N>::kEmpty) {
+    EntityData &entity_data = entities_[entity];
+    std::size_t archetype = archetypes_.With(empty, Entity::TypeID());
+    entity_data.archetype(archetype);
+    MarkUnsorted(archetype);
+    std::size_t handle = components_[Entity::TypeID()]->Add(archetype);
+    entity_data.component_handle(handle);
+    static_cast<Entity &>(
+        components_[Entity::TypeID()]->Get(archetype, handle)) = entity;
+  }
+
+  void Publish() {
+    ++tick_;
+    for (std::size_t component_type = 0; component_type < N;
+         ++component_type) {
+      if (snapshots_[component_type] == nullptr) {
+        continue;
+      }
+      // Not QueryOne, so that traces only record the queries of the user.
+      std::array<std::size_t, 2> component_ids = {Entity::TypeID(),
+                                                  component_type};
+      QueryCache &cache = Match(component_ids);
+      snapshots_[component_type]->Publish(
+          {Column(Entity::TypeID(), cache), Column(component_type, cache)},
+          tick_);
+    }
+  }
+
+  void MarkUnsorted(std::size_t archetype) {
+    if (!sort_keys_.empty()) {
+      unsorted_.insert(archetype);
+    }
+  }
+
+  // Write the archetypes, the regions, the entities and the hierarchy next to
+  // the files of the components. The file is replaced at once, so it stays
+  // consistent with the components synced before.
+  void SaveState() {
+    std::filesystem::path temporary = *state_;
+    temporary += ".tmp";
+    {
+      std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+      if (!file) {
+        throw std::runtime_error("Can't open world state " +
+                                 temporary.string());
+      }
+      file.write(kStateMagic.data(), kStateMagic.size());
+      WriteVarint(file, archetypes_.Size());
+      for (std::size_t archetype = 0; archetype < archetypes_.Size();
+           ++archetype) {
+        const auto &record = archetypes_[archetype];
+        file.put(static_cast<char>(record.prefab));
+        WriteVarint(file, record.region);
+        WriteVarint(file, record.components.size());
+        for (std::size_t component_type : record.components) {
+          WriteVarint(file, component_type);
+        }
+      }
+      WriteVarint(file, next_region_);
+      WriteVarint(file, free_regions_.size());
+      for (std::size_t region : free_regions_) {
+        WriteVarint(file, region);
+      }
+      entities_.Save(file);
+      std::span<const HierarchyNode> nodes = hierarchy_.Traverse();
+      WriteVarint(file, nodes.size());
+      for (const HierarchyNode &node : nodes) {
+        WriteVarint(file, node.entity.handle());
+        WriteVarint(file, node.parent == HierarchyNode::kNoParent
+                              ? 0
+                              : node.parent + 1);
+      }
+      if (!file.flush()) {
+        throw std::runtime_error("Can't write world state " +
+                                 temporary.string());
+      }
+    }
+    std::filesystem::rename(temporary, *state_);
+  }
+
+  // Read the file written by SaveState into the new world.
+  void RestoreState() {
+    std::ifstream file{*state_, std::ios::binary};
+    std::array<char, kStateMagic.size()> magic{};
+    file.read(magic.data(), magic.size());
+    if (!file || magic != kStateMagic) {
+      throw std::runtime_error("Not a world state " + state_->string());
+    }
+    try {
+      std::size_t num_archetypes = ReadVarint(file);
+      for (std::size_t archetype = 0; archetype < num_archetypes;
+           ++archetype) {
+        bool prefab = file.get() == 1;
+        std::size_t region = ReadVarint(file);
+        Archetype<N> signature;
+        std::size_t num_components = ReadVarint(file);
+        for (std::size_t idx = 0; idx < num_components; ++idx) {
+          std::size_t component_type = ReadVarint(file);
+          if (component_type >= N) {
+            throw std::runtime_error("Unknown component");
+          }
+          signature.Set(component_type);
+        }
+        // Interning in the same order gives the archetypes the same ids.
+        if ((prefab && region != 0) ||
+            archetypes_.Intern(signature, prefab, region) != archetype) {
+          throw std::runtime_error("Archetype mismatch");
+        }
+      }
+      next_region_ = ReadVarint(file);
+      free_regions_.resize(ReadVarint(file));
+      for (std::size_t &region : free_regions_) {
+        region = ReadVarint(file);
+      }
+      entities_.Load(file);
+      std::vector<Entity> linked(ReadVarint(file));
+      for (std::size_t idx = 0; idx < linked.size(); ++idx) {
+        linked[idx] = entities_.Find(ReadVarint(file));
+        std::size_t parent = ReadVarint(file);
+        if (!entities_.Alive(linked[idx]) || parent > idx) {
+          throw std::runtime_error("Unknown linked entity");
+        }
+        if (parent != 0) {
+          hierarchy_.Link(linked[idx], linked[parent - 1]);
+        }
+      }
+    } catch (const std::runtime_error &) {
+      throw std::runtime_error("Malformed world state " + state_->string());
+    }
+  }
+
+  // Checks that the reopened files hold exactly the rows of the restored
+  // entities. Changes made after the last Sync may have reached the files
+  // but not the state.
+  void CheckRestored() {
+    std::vector<std::size_t> rows(archetypes_.Size());
+    for (std::size_t handle = 0; handle < entities_.Capacity(); ++handle) {
+      Entity entity = entities_.Find(handle);
+      if (!entities_.Alive(entity)) {
+        continue;
+      }
+      const EntityData &entity_data = std::as_const(entities_)[entity];
+      std::size_t archetype = entity_data.archetype();
+      std::size_t row = entity_data.component_handle();
+      bool stored =
+          archetype < archetypes_.Size() &&
+          std::ranges::all_of(archetypes_[archetype].components,
+                              [&](std::size_t component_type) {
+                                return components_[component_type]->Contains(
+                                    archetype, row);
+                              }) &&
+          static_cast<const Entity &>(
+              std::as_const(*components_[Entity::TypeID()])
+                  .Get(archetype, row)) == entity;
+      if (!stored) {
+        throw std::runtime_error("World files are out of sync with " +
+                                 state_->string());
+      }
+      ++rows[archetype];
+    }
+    for (std::size_t archetype = 0; archetype < rows.size(); ++archetype) {
+      const DataPool<Entity> *column = EntityComponents().Find(archetype);
+      std::size_t size =
+          column == nullptr ? 0 : std::ranges::distance(*column);
+      if (size != rows[archetype]) {
+        throw std::runtime_error("World files are out of sync with " +
+                                 state_->string());
+      }
+      if (size != 0) {
+        MarkUnsorted(archetype);
+      }
+    }
+  }
+
+  static Archetype<N> MakeFilter(std::span<std::size_t> component_ids) {
+    Archetype<N> filter;
+    for (std::size_t component_id : component_ids) {
+      filter.Set(component_id);
+    }
+    return filter;
+  }
+
+  void Record(Change change, std::size_t component_type, std::size_t from,
+              std::size_t to, Entity entity) {
+    if (!observers_[component_type].empty()) {
+      changes_[component_type].Record(change, from, to, entity);
+    }
+  }
+
+  static void NotifyRemove(const std::vector<ComponentTrackerRef> &trackers,
+                           Entity entity) {
+    for (const ComponentTrackerRef &tracker : trackers) {
+      tracker->NotifyRemove(entity);
+    }
+  }
+
+  // Declared before the storages journaling into it.
+  ForkClock clock_;
+  // The last forks, oldest first.
+  std::deque<ForkState> forks_;
+  EntityPool entities_{};
+  internal::Hierarchy hierarchy_;
+  ArchetypeRegistry<N> archetypes_;
+  std::array<ComponentPoolRef, N> components_;
+  Scheduler scheduler_;
+  std::optional<std::chrono::steady_clock::time_point> last_update_;
+  std::array<std::vector<ComponentTrackerRef>, N> trackers_;
+  // Components added and removed together with the component including
+  // itself, see WorldBuilder::Split.
+  std::array<std::vector<std::size_t>, N> parts_;
+  std::array<std::vector<ComponentObserverRef>, N> observers_;
+  // Component types having observers.
+  std::vector<std::size_t> observed_;
+  std::array<ChangeLog, N> changes_;
+  std::array<ChangeLog, N> delivering_;
+  std::vector<SortKey> sort_keys_;
+  std::unordered_set<std::size_t> unsorted_;
+  std::unordered_map<Archetype<N>, QueryCache> queries_;
+  // Per archetype, the storages found by Columns.
+  std::vector<std::vector<void *>> located_;
+  // Keyed by the queried component types in the order of the query.
+  std::map<std::vector<std::size_t>, GroupCache> groups_;
+  // Null for the components stored per entity, see WorldBuilder::Shared.
+  std::array<SharedPoolRef, N> shared_;
+  // Indexed by event type ids, which are shared by all the worlds.
+  std::vector<EventChannelRef> channels_;
+  std::array<SnapshotBufferRef, N> snapshots_;
+  // Some components are stored in files, see WorldBuilder::PageToFiles.
+  bool mapped_{false};
+  // Set if the whole world is stored in files and can be restored.
+  std::optional<std::filesystem::path> state_;
+  // Region ids are handed out from one and reused once unloaded.
+  std::size_t next_region_{1};
+  std::vector<std::size_t> free_regions_;
+  // Number of Update calls.
+  std::uint64_t tick_{0};
+  // Owners of the resources found by World::Resource.
+  std::vector<std::shared_ptr<void>> owned_resources_;
+  // Null unless the calls are recorded.
+  std::unique_ptr<TraceWriter> trace_;
 };
 
 }  // namespace ecsify::internal
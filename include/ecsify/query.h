@@ -0,0 +1,141 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_QUERY_H_
+#define ECSIFY_INCLUDE_ECSIFY_QUERY_H_
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ecsify/internal/data_pool.h"
+
+namespace ecsify {
+
+// Rows of every archetype having all the Components. Iteration yields tuples
+// of references and walks the rows of one archetype bucket by bucket. Rows
+// with any of the Components disabled are skipped, see World::Disable.
+// Structural changes of the world invalidate the view. Components only read
+// should be const, so that forks of the world don't copy them, see
+// World::Fork.
+template <class... Components>
+  requires(sizeof...(Components) > 0)
+class QueryView final {
+ public:
+  // Per component, its storage in every matching archetype. Storages of the
+  // same archetype are at the same position in every column.
+  using Columns = std::array<std::span<void *const>, sizeof...(Components)>;
+
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::tuple<Components &...>;
+    using reference = std::tuple<Components &...>;
+
+    Iterator() = default;
+
+    explicit Iterator(const Columns &columns) : columns_{columns} { Settle(); }
+
+    reference operator*() const {
+      std::size_t row = std::countr_zero(mask_);
+      return std::apply(
+          [row](auto *...buckets) { return reference{(*buckets)[row]...}; },
+          buckets_);
+    }
+
+    Iterator &operator++() {
+      mask_ &= mask_ - 1;
+      if (mask_ == 0) {
+        ++bucket_;
+        Settle();
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return archetype_ == other.archetype_ && bucket_ == other.bucket_ &&
+             mask_ == other.mask_;
+    }
+
+    bool operator==(std::default_sentinel_t) const {
+      return archetype_ == columns_[0].size();
+    }
+
+   private:
+    template <std::size_t I>
+    using Component = std::tuple_element_t<I, std::tuple<Components...>>;
+
+    template <std::size_t I>
+    using Pool = std::conditional_t<
+        std::is_const_v<Component<I>>,
+        const internal::DataPool<std::remove_const_t<Component<I>>>,
+        internal::DataPool<std::remove_const_t<Component<I>>>>;
+
+    template <class C>
+    using BucketOf = std::conditional_t<
+        std::is_const_v<C>, const internal::Bucket<std::remove_const_t<C>>,
+        internal::Bucket<std::remove_const_t<C>>>;
+
+    template <std::size_t I>
+    Pool<I> &PoolAt() const {
+      return *static_cast<Pool<I> *>(columns_[I][archetype_]);
+    }
+
+    // Moves to the first enabled row at or after the current bucket.
+    void Settle() {
+      for (; archetype_ < columns_[0].size(); ++archetype_, bucket_ = 0) {
+        const auto &pool = std::as_const(PoolAt<0>());
+        for (; bucket_ < pool.NumBuckets(); ++bucket_) {
+          mask_ = EnabledMask(std::index_sequence_for<Components...>{});
+          if (mask_ != 0) {
+            LoadBuckets(std::index_sequence_for<Components...>{});
+            return;
+          }
+        }
+      }
+      bucket_ = 0;
+      mask_ = 0;
+    }
+
+    // Rows are visited when every component is enabled. Masks are read
+    // through const buckets, so that skipped buckets aren't journaled.
+    template <std::size_t... I>
+    std::uint64_t EnabledMask(std::index_sequence<I...>) const {
+      return (std::as_const(PoolAt<I>()).BucketAt(bucket_).EnabledMask() &
+              ...);
+    }
+
+    template <std::size_t... I>
+    void LoadBuckets(std::index_sequence<I...>) {
+      buckets_ = {&PoolAt<I>().BucketAt(bucket_)...};
+    }
+
+    Columns columns_{};
+    std::tuple<BucketOf<Components> *...> buckets_{};
+    std::size_t archetype_{0};
+    std::size_t bucket_{0};
+    std::uint64_t mask_{0};
+  };
+
+  explicit QueryView(Columns columns) : columns_{columns} {}
+
+  Iterator begin() const { return Iterator{columns_}; }
+  std::default_sentinel_t end() const { return std::default_sentinel; }
+
+ private:
+  Columns columns_;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_QUERY_H_
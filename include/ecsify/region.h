@@ -0,0 +1,111 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_REGION_H_
+#define ECSIFY_INCLUDE_ECSIFY_REGION_H_
+
+#include <array>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ecsify {
+
+namespace internal {
+
+template <std::size_t N>
+class WorldImpl;
+
+inline constexpr std::array<char, 8> kRegionMagic = {'e', 'c', 's', 'i',
+                                                     'f', 'y', 'r', '2'};
+
+// Rows of one component prepared apart from the world, see RegionColumn.
+struct RegionColumnBase {
+  virtual ~RegionColumnBase() = default;
+};
+
+using RegionColumnRef = std::unique_ptr<RegionColumnBase>;
+
+inline void WriteVarint(std::ostream &out, std::size_t value) {
+  while (value >= 0x80) {
+    out.put(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+inline std::size_t ReadVarint(std::istream &in) {
+  std::size_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    int byte = in.get();
+    if (byte == std::istream::traits_type::eof()) {
+      throw std::runtime_error("Truncated region");
+    }
+    value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::runtime_error("Malformed region");
+}
+
+}  // namespace internal
+
+// A group of entities stored in archetypes of its own, so that it can be
+// saved, loaded and unloaded as a whole, see World::AddRegion. Queries visit
+// the entities of all the regions and of the rest of the world alike.
+class Region final {
+ public:
+  // Not a region: the rest of the world.
+  Region() : id_{0} {}
+  explicit Region(std::size_t region_id) : id_{region_id} {}
+
+  std::size_t id() const noexcept { return id_; }
+
+  friend bool operator==(const Region &lhs, const Region &rhs) = default;
+
+ private:
+  std::size_t id_;
+};
+
+/**
+ * @brief Components of a region read from a file by World::PrepareRegion and
+ * waiting to be spliced into the world by World::LoadRegion.
+ *
+ * The file holds a table per archetype of the region: its component types
+ * and sizes followed by the raw bytes of every column and of every shared
+ * value. The columns are read into storages shaped like the ones of the world,
+ * so loading only hands them over and gives ids to the entities.
+ */
+class RegionChunk final {
+ public:
+  // Number of entities in the region.
+  std::size_t size() const noexcept {
+    std::size_t result = 0;
+    for (const Table &table : tables_) {
+      result += table.size;
+    }
+    return result;
+  }
+
+ private:
+  template <std::size_t N>
+  friend class internal::WorldImpl;
+
+  struct Table {
+    // Component types in increasing order, starting with the Entity.
+    std::vector<std::size_t> components;
+    std::vector<internal::RegionColumnRef> columns;
+    // Shared component types in increasing order and single row columns
+    // holding their values.
+    std::vector<std::pair<std::size_t, internal::RegionColumnRef>> shared;
+    std::size_t size;
+  };
+
+  std::vector<Table> tables_;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_REGION_H_
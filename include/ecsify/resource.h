@@ -0,0 +1,28 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_RESOURCE_H_
+#define ECSIFY_INCLUDE_ECSIFY_RESOURCE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace ecsify::internal {
+
+// Creates the resource of a world. Every world gets its own copy.
+using ResourceFactory = std::function<std::shared_ptr<void>()>;
+
+inline std::size_t NextResourceTypeID() noexcept {
+  static std::atomic<std::size_t> next_id{0};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Resources are plain types, so their ids are assigned on first use.
+template <class Resource>
+std::size_t ResourceTypeID() noexcept {
+  static const std::size_t id = NextResourceTypeID();
+  return id;
+}
+
+}  // namespace ecsify::internal
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_RESOURCE_H_
@@ -0,0 +1,37 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_SCHEDULE_H_
+#define ECSIFY_INCLUDE_ECSIFY_SCHEDULE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <variant>
+
+namespace ecsify {
+
+using Duration = std::chrono::nanoseconds;
+
+// Phases of a tick, run in the declaration order.
+enum class Phase : std::size_t { kPreUpdate, kUpdate, kPostUpdate };
+
+inline constexpr std::size_t kNumPhases = 3;
+
+// Run the group once per tick.
+struct EveryTick {};
+
+// Run the group once per step of simulated time. Time of every tick is
+// accumulated and the group catches up by running several times per tick,
+// but no more than max_steps times, dropping the rest.
+struct FixedStep {
+  Duration step;
+  std::size_t max_steps = 8;
+};
+
+// Run the group once per divisor ticks, starting from the first one.
+struct TickDivisor {
+  std::size_t divisor;
+};
+
+using Rate = std::variant<EveryTick, FixedStep, TickDivisor>;
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_SCHEDULE_H_
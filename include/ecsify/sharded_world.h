@@ -0,0 +1,145 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_SHARDED_WORLD_H_
+#define ECSIFY_INCLUDE_ECSIFY_SHARDED_WORLD_H_
+
+#include <atomic>
+#include <barrier>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ecsify/entity.h"
+#include "ecsify/internal/numa.h"
+#include "ecsify/world.h"
+
+namespace ecsify {
+
+// Placement of the shard workers on the machine.
+enum class Placement {
+  // Workers run wherever the OS schedules them.
+  kAny,
+  // Worker i is pinned to the CPUs of NUMA node i modulo the number of nodes
+  // and prefers its memory. Storage is allocated by the thread first touching
+  // it, so a shard populated by its worker stays on the worker's node.
+  kNuma,
+};
+
+/**
+ * @brief A set of worlds sharing the components and systems, each owning a
+ * part of the simulation (e.g. a map region).
+ *
+ * Every shard is driven by its own worker thread, so shards must not touch
+ * each other while running. Entities are moved between shards with Migrate
+ * between runs. Entity ids are unique within a shard only.
+ *
+ * Components are allocated on the NUMA node of the thread writing them first.
+ * With Placement::kNuma every shard is processed on one node, so add entities
+ * to a shard from its worker (see Run) to keep its storage local.
+ */
+class ShardedWorld final {
+ public:
+  using Task = std::function<void(World &)>;
+
+  explicit ShardedWorld(std::vector<std::unique_ptr<World>> shards,
+                        Placement placement = Placement::kAny)
+      : shards_{std::move(shards)},
+        placement_{placement},
+        sync_{static_cast<std::ptrdiff_t>(Size() + 1)} {
+    if (placement_ == Placement::kNuma) {
+      nodes_ = internal::NumaNodes();
+    }
+    workers_.reserve(Size());
+    for (std::size_t idx = 0; idx < Size(); ++idx) {
+      workers_.emplace_back([this, idx] { Work(idx); });
+    }
+  }
+
+  ShardedWorld(const ShardedWorld &) = delete;
+  ShardedWorld &operator=(const ShardedWorld &) = delete;
+
+  ~ShardedWorld() {
+    stop_ = true;
+    sync_.arrive_and_wait();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  std::size_t Size() const noexcept { return shards_.size(); }
+
+  World &operator[](std::size_t idx) noexcept { return *shards_[idx]; }
+  const World &operator[](std::size_t idx) const noexcept {
+    return *shards_[idx];
+  }
+
+  // Id of the NUMA node the shard is processed on, zero unless placed with
+  // Placement::kNuma.
+  int Node(std::size_t shard) const noexcept {
+    return nodes_.empty() ? 0 : nodes_[shard % nodes_.size()].id;
+  }
+
+  // Move the entities with all their components from one shard to another.
+  // Returns the entities in the destination shard in the same order. With
+  // Placement::kNuma the components are copied by the destination worker, so
+  // they land on its node.
+  std::vector<Entity> Migrate(std::span<const Entity> entities,
+                              std::size_t from, std::size_t to) {
+    if (placement_ != Placement::kNuma) {
+      return shards_[from]->Migrate(entities, *shards_[to]);
+    }
+    std::vector<Entity> result;
+    Run([&](World &world) {
+      if (&world == shards_[to].get()) {
+        result = shards_[from]->Migrate(entities, world);
+      }
+    });
+    return result;
+  }
+
+  // Run the task on every shard in parallel and wait for all of them.
+  void Run(const Task &task) {
+    task_ = &task;
+    sync_.arrive_and_wait();
+    sync_.arrive_and_wait();
+    task_ = nullptr;
+  }
+
+  // Update all the shards in parallel.
+  void Update() {
+    Run([](World &world) { world.Update(); });
+  }
+
+ private:
+  void Work(std::size_t idx) {
+    if (!nodes_.empty()) {
+      internal::BindThreadToNode(nodes_[idx % nodes_.size()]);
+    }
+    while (true) {
+      sync_.arrive_and_wait();
+      if (stop_) {
+        return;
+      }
+      (*task_)(*shards_[idx]);
+      sync_.arrive_and_wait();
+    }
+  }
+
+  std::vector<std::unique_ptr<World>> shards_;
+  Placement placement_;
+  // Nodes the workers are spread over, empty unless placed with
+  // Placement::kNuma.
+  std::vector<internal::NumaNode> nodes_;
+  std::vector<std::thread> workers_;
+  // Workers and the caller meet here before and after every task.
+  std::barrier<> sync_;
+  const Task *task_{nullptr};
+  std::atomic<bool> stop_{false};
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_SHARDED_WORLD_H_
@@ -0,0 +1,101 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_SHARED_H_
+#define ECSIFY_INCLUDE_ECSIFY_SHARED_H_
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/query.h"
+
+namespace ecsify {
+
+namespace internal {
+
+// Archetypes matching a query which share a value, see SharedGroups.
+struct SharedGroup {
+  const ComponentBase *value;
+  // Per queried component, its storages in the archetypes of the group.
+  std::vector<std::vector<void *>> columns;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Rows of the entities having the Shared component and all the
+ * Components, grouped by the value of the Shared one.
+ *
+ * Iteration yields a Group per distinct value: the value, stored once for the
+ * whole group, and a QueryView over the rows of its entities. Entities with
+ * equal values live in the same archetypes, so the groups cost nothing to
+ * form. Groups stay in the order their values first appeared and may be empty
+ * once their entities are gone. Structural changes of the world invalidate
+ * the view.
+ */
+template <class Shared, class... Components>
+  requires(sizeof...(Components) > 0)
+class SharedGroups final {
+ public:
+  struct Group {
+    const Shared &value;
+    QueryView<Components...> rows;
+  };
+
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = Group;
+    using reference = Group;
+
+    Iterator() = default;
+
+    explicit Iterator(const internal::SharedGroup *group) : group_{group} {}
+
+    reference operator*() const {
+      return Group{.value = static_cast<const Shared &>(*group_->value),
+                   .rows = QueryView<Components...>{Columns(
+                       std::index_sequence_for<Components...>{})}};
+    }
+
+    Iterator &operator++() {
+      ++group_;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++group_;
+      return tmp;
+    }
+
+    bool operator==(const Iterator &other) const = default;
+
+   private:
+    template <std::size_t... I>
+    typename QueryView<Components...>::Columns Columns(
+        std::index_sequence<I...>) const {
+      return {std::span<void *const>(group_->columns[I])...};
+    }
+
+    const internal::SharedGroup *group_{nullptr};
+  };
+
+  explicit SharedGroups(std::span<const internal::SharedGroup> groups)
+      : groups_{groups} {}
+
+  Iterator begin() const { return Iterator{groups_.data()}; }
+  Iterator end() const { return Iterator{groups_.data() + groups_.size()}; }
+
+  // Number of distinct values.
+  std::size_t size() const noexcept { return groups_.size(); }
+
+ private:
+  std::span<const internal::SharedGroup> groups_;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_SHARED_H_
@@ -0,0 +1,181 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_SNAPSHOT_H_
+#define ECSIFY_INCLUDE_ECSIFY_SNAPSHOT_H_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ecsify/entity.h"
+#include "ecsify/internal/data_pool.h"
+
+namespace ecsify {
+
+namespace internal {
+
+template <class T>
+class SnapshotBuffer;
+
+}  // namespace internal
+
+// Values of the T components as of the end of a tick, see World::Snapshot.
+// Rows of entities and values are at the same positions.
+template <class T>
+class ComponentSnapshot final {
+ public:
+  // Number of the Update calls which ran before the snapshot was taken.
+  std::uint64_t tick() const noexcept { return tick_; }
+
+  std::span<const Entity> entities() const noexcept { return entities_; }
+
+  std::span<const T> values() const noexcept { return values_; }
+
+  std::size_t size() const noexcept { return entities_.size(); }
+
+ private:
+  template <class>
+  friend class internal::SnapshotBuffer;
+
+  std::uint64_t tick_{0};
+  std::vector<Entity> entities_;
+  std::vector<T> values_;
+};
+
+namespace internal {
+
+struct SnapshotBufferBase {
+  virtual ~SnapshotBufferBase() = default;
+
+  // Copy the rows of the entity and the component columns and publish them.
+  virtual void Publish(std::array<std::span<void *const>, 2> columns,
+                       std::uint64_t tick) = 0;
+};
+
+using SnapshotBufferRef = std::unique_ptr<SnapshotBufferBase>;
+
+// Rows of a bucket copied into a snapshot, see SnapshotBuffer.
+struct SnapshotSegment {
+  // The DataPool the rows were copied from.
+  const void *pool;
+  std::size_t bucket;
+  // Versions of the entity and the component buckets, see DataPool::Version.
+  std::uint64_t entities_version;
+  std::uint64_t values_version;
+  // Position and number of the rows in the snapshot.
+  std::size_t offset;
+  std::size_t size;
+
+  friend bool operator==(const SnapshotSegment &lhs,
+                         const SnapshotSegment &rhs) = default;
+};
+
+// Snapshots of one component type. Publishing refills a buffer no reader
+// holds and swaps it in, so readers keep a consistent snapshot for as long as
+// they hold it and the steady state allocates nothing. Every buffer remembers
+// which bucket versions it holds where, so the refill only copies the buckets
+// changed since the buffer was published last, and the ones moved by changes
+// of the number of rows before them. Rows with the component disabled aren't
+// copied.
+template <class T>
+class SnapshotBuffer final : public SnapshotBufferBase {
+ public:
+  SnapshotBuffer()
+      : published_{std::make_shared<ComponentSnapshot<T>>()} {}
+
+  // Thread-safe.
+  std::shared_ptr<const ComponentSnapshot<T>> Latest() const {
+    return published_.load(std::memory_order_acquire);
+  }
+
+  // The pools must track their writes, see DataPool::TrackWrites.
+  void Publish(std::array<std::span<void *const>, 2> columns,
+               std::uint64_t tick) override {
+    ComponentSnapshot<T> &snapshot = Free();
+    std::vector<SnapshotSegment> &segments = segments_[free_];
+    snapshot.tick_ = tick;
+    std::size_t offset = 0;
+    std::size_t segment_idx = 0;
+    for (std::size_t archetype = 0; archetype < columns[0].size();
+         ++archetype) {
+      const auto &entities =
+          *static_cast<const DataPool<Entity> *>(columns[0][archetype]);
+      const auto &values =
+          *static_cast<const DataPool<T> *>(columns[1][archetype]);
+      for (std::size_t bucket_idx = 0; bucket_idx < values.NumBuckets();
+           ++bucket_idx, ++segment_idx) {
+        std::uint64_t mask = entities.BucketAt(bucket_idx).EnabledMask() &
+                             values.BucketAt(bucket_idx).EnabledMask();
+        SnapshotSegment segment{
+            .pool = &values,
+            .bucket = bucket_idx,
+            .entities_version = entities.Version(bucket_idx),
+            .values_version = values.Version(bucket_idx),
+            .offset = offset,
+            .size = static_cast<std::size_t>(std::popcount(mask))};
+        offset += segment.size;
+        if (segment_idx < segments.size() && segments[segment_idx] == segment) {
+          continue;
+        }
+        Copy(entities.BucketAt(bucket_idx), values.BucketAt(bucket_idx), mask,
+             segment.offset, snapshot);
+        if (segment_idx < segments.size()) {
+          segments[segment_idx] = segment;
+        } else {
+          segments.push_back(segment);
+        }
+      }
+    }
+    segments.resize(segment_idx);
+    snapshot.entities_.resize(offset);
+    snapshot.values_.resize(offset);
+    published_.store(buffers_[free_], std::memory_order_release);
+  }
+
+ private:
+  static void Copy(const Bucket<Entity> &entities, const Bucket<T> &values,
+                   std::uint64_t mask, std::size_t offset,
+                   ComponentSnapshot<T> &snapshot) {
+    std::size_t end = offset + std::popcount(mask);
+    if (snapshot.values_.size() < end) {
+      snapshot.entities_.resize(end);
+      snapshot.values_.resize(end);
+    }
+    for (; mask != 0; mask &= mask - 1, ++offset) {
+      std::size_t idx = std::countr_zero(mask);
+      snapshot.entities_[offset] = entities[idx];
+      snapshot.values_[offset] = values[idx];
+    }
+  }
+
+  // A buffer which is neither published nor held by readers. Three buffers
+  // suffice unless readers hold snapshots for longer than a tick.
+  ComponentSnapshot<T> &Free() {
+    for (free_ = 0; free_ < buffers_.size(); ++free_) {
+      // Unpublished buffers can't be acquired by readers anymore, so a single
+      // owner stays the single one.
+      if (buffers_[free_].use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return *buffers_[free_];
+      }
+    }
+    buffers_.push_back(std::make_shared<ComponentSnapshot<T>>());
+    segments_.emplace_back();
+    return *buffers_.back();
+  }
+
+  std::atomic<std::shared_ptr<const ComponentSnapshot<T>>> published_;
+  std::vector<std::shared_ptr<ComponentSnapshot<T>>> buffers_;
+  // Per buffer, the buckets copied into it in the order of the rows.
+  std::vector<std::vector<SnapshotSegment>> segments_;
+  std::size_t free_{0};
+};
+
+}  // namespace internal
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_SNAPSHOT_H_
@@ -0,0 +1,246 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_SPATIAL_GRID_H_
+#define ECSIFY_INCLUDE_ECSIFY_SPATIAL_GRID_H_
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ecsify/component_tracker.h"
+#include "ecsify/entity.h"
+
+namespace ecsify {
+
+// Reads coordinates from x, y (and z for 3D) members of the component.
+template <class Component, std::size_t kDims>
+  requires(kDims == 2 || kDims == 3)
+struct MemberProjection {
+  std::array<float, kDims> operator()(const Component &component) const {
+    if constexpr (kDims == 2) {
+      return {component.x, component.y};
+    } else {
+      return {component.x, component.y, component.z};
+    }
+  }
+};
+
+/**
+ * @brief A uniform grid over the positions stored in the Component.
+ *
+ * The grid is a ComponentTracker, so once registered with
+ * WorldBuilder::Track<Component> it is updated incrementally: only entities
+ * whose component is added, removed, written with World::Set or reported via
+ * World::Modified are touched, and an entity is relocated only when it moves
+ * to another cell. Box and radius queries visit only the overlapped cells.
+ *
+ * @tparam Component The component holding the position.
+ * @tparam kDims Number of dimensions, 2 or 3.
+ * @tparam Projection Callable mapping the component to its coordinates.
+ */
+template <class Component, std::size_t kDims = 2,
+          class Projection = MemberProjection<Component, kDims>>
+class SpatialGrid final : public ComponentTracker<Component> {
+ public:
+  using Point = std::array<float, kDims>;
+
+  explicit SpatialGrid(float cell_size, Projection projection = Projection{})
+      : cell_size_{cell_size}, projection_{std::move(projection)} {
+    assert(cell_size > 0 && "Cell size must be positive");
+  }
+
+  void OnAdd(Entity entity, const Component &component) override {
+    Insert(entity, projection_(component));
+  }
+
+  void OnSet(Entity entity, const Component &component) override {
+    Point point = projection_(component);
+    CellKey cell = CellOf(point);
+    if (entity.handle() < locations_.size()) {
+      const Location &location = locations_[entity.handle()];
+      if (location.idx != Location::kNone && location.cell == cell) {
+        cells_[cell][location.idx].point = point;
+        return;
+      }
+    }
+    Erase(entity);
+    Insert(entity, point);
+  }
+
+  void OnRemove(Entity entity) override { Erase(entity); }
+
+  // Append entities inside the box [min, max] to the result.
+  void QueryBox(const Point &min, const Point &max,
+                std::vector<Entity> &result) const {
+    ForEachCell(min, max, [&](const std::vector<Entry> &cell) {
+      for (const Entry &entry : cell) {
+        if (Inside(entry.point, min, max)) {
+          result.push_back(entry.entity);
+        }
+      }
+    });
+  }
+
+  // Append entities within the radius around the center to the result.
+  void QueryRadius(const Point &center, float radius,
+                   std::vector<Entity> &result) const {
+    Point min = center;
+    Point max = center;
+    for (std::size_t dim = 0; dim < kDims; ++dim) {
+      min[dim] -= radius;
+      max[dim] += radius;
+    }
+    float radius_sq = radius * radius;
+    ForEachCell(min, max, [&](const std::vector<Entry> &cell) {
+      for (const Entry &entry : cell) {
+        if (DistanceSquared(entry.point, center) <= radius_sq) {
+          result.push_back(entry.entity);
+        }
+      }
+    });
+  }
+
+  std::size_t Size() const noexcept { return size_; }
+
+ private:
+  using CellKey = std::array<std::int32_t, kDims>;
+
+  struct CellHash {
+    std::size_t operator()(const CellKey &key) const noexcept {
+      std::size_t result = 0;
+      for (std::int32_t coord : key) {
+        // Boost's hash_combine.
+        result ^= std::hash<std::int32_t>{}(coord) + 0x9e3779b9 +
+                  (result << 6) + (result >> 2);
+      }
+      return result;
+    }
+  };
+
+  struct Entry {
+    Entity entity;
+    Point point;
+  };
+
+  // Position of the entity inside the grid, indexed by entity handle.
+  struct Location {
+    static constexpr std::size_t kNone =
+        std::numeric_limits<std::size_t>::max();
+
+    CellKey cell{};
+    std::size_t idx{kNone};
+  };
+
+  CellKey CellOf(const Point &point) const noexcept {
+    CellKey key;
+    for (std::size_t dim = 0; dim < kDims; ++dim) {
+      key[dim] =
+          static_cast<std::int32_t>(std::floor(point[dim] / cell_size_));
+    }
+    return key;
+  }
+
+  void Insert(Entity entity, const Point &point) {
+    if (entity.handle() >= locations_.size()) {
+      locations_.resize(entity.handle() + 1);
+    }
+    Location &location = locations_[entity.handle()];
+    assert(location.idx == Location::kNone && "Entity is already indexed");
+    location.cell = CellOf(point);
+    std::vector<Entry> &cell = cells_[location.cell];
+    location.idx = cell.size();
+    cell.push_back(Entry{.entity = entity, .point = point});
+    ++size_;
+  }
+
+  void Erase(Entity entity) {
+    if (entity.handle() >= locations_.size()) {
+      return;
+    }
+    Location &location = locations_[entity.handle()];
+    if (location.idx == Location::kNone) {
+      return;
+    }
+    auto cell_it = cells_.find(location.cell);
+    std::vector<Entry> &cell = cell_it->second;
+    // Swap with the last entry to erase in O(1).
+    Entry &last = cell.back();
+    locations_[last.entity.handle()].idx = location.idx;
+    cell[location.idx] = last;
+    cell.pop_back();
+    if (cell.empty()) {
+      cells_.erase(cell_it);
+    }
+    location.idx = Location::kNone;
+    --size_;
+  }
+
+  template <class F>
+  void ForEachCell(const Point &min, const Point &max, F &&func) const {
+    CellKey from = CellOf(min);
+    CellKey to = CellOf(max);
+    std::size_t num_cells = 1;
+    for (std::size_t dim = 0; dim < kDims; ++dim) {
+      num_cells *= static_cast<std::size_t>(to[dim] - from[dim] + 1);
+    }
+    // Sparse grids are cheaper to scan than a large empty box.
+    if (num_cells > cells_.size()) {
+      for (const auto &[key, cell] : cells_) {
+        if (Inside(key, from, to)) {
+          func(cell);
+        }
+      }
+      return;
+    }
+    CellKey key = from;
+    while (true) {
+      auto it = cells_.find(key);
+      if (it != cells_.end()) {
+        func(it->second);
+      }
+      std::size_t dim = 0;
+      for (; dim < kDims && key[dim] == to[dim]; ++dim) {
+        key[dim] = from[dim];
+      }
+      if (dim == kDims) {
+        return;
+      }
+      ++key[dim];
+    }
+  }
+
+  template <class Coords>
+  static bool Inside(const Coords &coords, const Coords &min,
+                     const Coords &max) noexcept {
+    for (std::size_t dim = 0; dim < kDims; ++dim) {
+      if (coords[dim] < min[dim] || coords[dim] > max[dim]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static float DistanceSquared(const Point &lhs, const Point &rhs) noexcept {
+    float result = 0;
+    for (std::size_t dim = 0; dim < kDims; ++dim) {
+      float delta = lhs[dim] - rhs[dim];
+      result += delta * delta;
+    }
+    return result;
+  }
+
+  float cell_size_;
+  Projection projection_;
+  std::unordered_map<CellKey, std::vector<Entry>, CellHash> cells_;
+  std::vector<Location> locations_;
+  std::size_t size_{0};
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_SPATIAL_GRID_H_
@@ -0,0 +1,214 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_TASK_H_
+#define ECSIFY_INCLUDE_ECSIFY_TASK_H_
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "ecsify/schedule.h"
+
+namespace ecsify {
+
+class World;
+
+/**
+ * @brief Return type of coroutine systems.
+ *
+ * A system returning Task is started on the first Update and resumed on the
+ * following ones until it finishes, after which it is started again. The
+ * coroutine frame is allocated once per start, so resuming doesn't allocate.
+ * Long-running systems should loop and suspend with the awaitables below:
+ *
+ *   ecsify::Task Plan(ecsify::World &world) {
+ *     while (true) {
+ *       for (...) {
+ *         co_await ecsify::TimeBudget{std::chrono::microseconds{500}};
+ *       }
+ *       co_await ecsify::NextTick{};
+ *     }
+ *   }
+ */
+class Task final {
+ public:
+  struct promise_type {
+    using Clock = std::chrono::steady_clock;
+
+    Task get_return_object() noexcept {
+      return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    // The system runner resumes the task within Update.
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    std::suspend_always final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() noexcept {
+      exception = std::current_exception();
+    }
+
+    // Number of upcoming ticks to skip before resuming.
+    std::size_t sleep_ticks{0};
+    // Phase to resume in instead of the phase of the system.
+    std::optional<Phase> wake_phase;
+    Clock::time_point resumed_at{};
+    std::exception_ptr exception;
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task() noexcept = default;
+  explicit Task(Handle handle) noexcept : handle_{handle} {}
+
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  Task(Task &&other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+  Task &operator=(Task &&other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool Done() const noexcept { return !handle_ || handle_.done(); }
+
+  // Resume the task for the current tick unless it sleeps or waits for a
+  // phase.
+  void Tick() {
+    promise_type &promise = handle_.promise();
+    if (promise.wake_phase.has_value()) {
+      return;
+    }
+    if (promise.sleep_ticks > 0) {
+      --promise.sleep_ticks;
+      return;
+    }
+    ResumeNow();
+  }
+
+  // Resume the task if it waits for the phase. Returns whether it resumed.
+  bool Wake(Phase phase) {
+    std::optional<Phase> &wake_phase = handle_.promise().wake_phase;
+    if (wake_phase != phase) {
+      return false;
+    }
+    wake_phase.reset();
+    ResumeNow();
+    return true;
+  }
+
+ private:
+  void ResumeNow() {
+    promise_type &promise = handle_.promise();
+    promise.resumed_at = promise_type::Clock::now();
+    handle_.resume();
+    if (promise.exception) {
+      std::rethrow_exception(std::exchange(promise.exception, {}));
+    }
+  }
+
+  Handle handle_{};
+};
+
+// Suspend until the next tick.
+struct NextTick {
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(Task::Handle /*handle*/) const noexcept {}
+  void await_resume() const noexcept {}
+};
+
+// Suspend for the number of ticks. Sleeping for 0 ticks doesn't suspend.
+struct SleepTicks {
+  std::size_t ticks;
+
+  bool await_ready() const noexcept { return ticks == 0; }
+  void await_suspend(Task::Handle handle) const noexcept {
+    handle.promise().sleep_ticks = ticks - 1;
+  }
+  void await_resume() const noexcept {}
+};
+
+// Suspend until the phase starts: later in the same tick if the phase is yet
+// to come or in the next tick otherwise.
+struct WaitPhase {
+  Phase phase;
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(Task::Handle handle) const noexcept {
+    handle.promise().wake_phase = phase;
+  }
+  void await_resume() const noexcept {}
+};
+
+// Suspend until the next tick only if the task has been running for longer
+// than the budget since it was resumed. Put it into long loops to spread
+// their cost over several ticks.
+struct TimeBudget {
+  std::chrono::nanoseconds budget;
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(Task::Handle handle) const noexcept {
+    return Task::promise_type::Clock::now() - handle.promise().resumed_at >=
+           budget;
+  }
+  void await_resume() const noexcept {}
+};
+
+namespace internal {
+
+// Adapts a coroutine system to the regular system interface. Copies start
+// their own coroutines, so copied configurations don't share the state.
+class CoroutineSystem final {
+ public:
+  explicit CoroutineSystem(std::function<Task(World &)> factory)
+      : factory_{std::move(factory)} {}
+
+  CoroutineSystem(const CoroutineSystem &other) : factory_{other.factory_} {}
+  CoroutineSystem &operator=(const CoroutineSystem &other) {
+    factory_ = other.factory_;
+    task_ = Task{};
+    return *this;
+  }
+  CoroutineSystem(CoroutineSystem &&) noexcept = default;
+  CoroutineSystem &operator=(CoroutineSystem &&) noexcept = default;
+  ~CoroutineSystem() = default;
+
+  void operator()(World &world) {
+    // The coroutine has already run in an earlier phase of this tick.
+    if (std::exchange(woken_, false)) {
+      return;
+    }
+    if (task_.Done()) {
+      task_ = factory_(world);
+    }
+    task_.Tick();
+  }
+
+  // Resume the coroutine if it waits for the phase. Called by the scheduler
+  // whenever a phase starts.
+  void Resume(Phase phase) {
+    if (phase == Phase::kPreUpdate) {
+      woken_ = false;
+    }
+    if (!task_.Done() && task_.Wake(phase)) {
+      woken_ = true;
+    }
+  }
+
+ private:
+  std::function<Task(World &)> factory_;
+  Task task_;
+  bool woken_{false};
+};
+
+}  // namespace internal
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_TASK_H_
@@ -0,0 +1,235 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_TRACE_H_
+#define ECSIFY_INCLUDE_ECSIFY_TRACE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "ecsify/entity.h"
+
+namespace ecsify {
+
+enum class TraceOp : std::uint8_t {
+  kAddEntity,
+  kRemoveEntity,
+  kAddComponent,
+  kRemoveComponent,
+  kGetComponent,
+  kQuery,
+};
+
+inline constexpr std::size_t kNumTraceOps = 6;
+
+// Entities are identified by their handles, which are unique among the alive
+// entities.
+struct TraceRecord {
+  TraceOp op{};
+  std::size_t entity{};
+  std::size_t component{};
+  // Components of the query.
+  std::vector<std::size_t> components;
+};
+
+namespace internal {
+
+inline constexpr std::array<char, 8> kTraceMagic = {'e', 'c', 's', 'i',
+                                                    'f', 'y', 't', '1'};
+
+}  // namespace internal
+
+/**
+ * @brief Writes World calls into a compact binary trace, see
+ * WorldBuilder::RecordTrace.
+ *
+ * The trace starts with a header holding the sizes of the components by type
+ * id. Every record is the operation byte followed by its arguments encoded as
+ * LEB128 varints, so most records take two or three bytes. Records are
+ * buffered and written in large blocks.
+ *
+ * Only the calls of TraceOp are recorded. Prefabs and Instantiate, regions,
+ * RemoveAll, AddToAll and RemoveFromAll, SetShared and QueryShared,
+ * SetEnabled, the hierarchy, Fork and Rollback aren't, so replays skip the
+ * later records of the entities they create, move or restore.
+ */
+class TraceWriter final {
+ public:
+  TraceWriter(const std::filesystem::path &path,
+              std::span<const std::size_t> component_sizes)
+      : file_{path, std::ios::binary | std::ios::trunc} {
+    if (!file_) {
+      throw std::runtime_error("Can't open trace " + path.string());
+    }
+    buffer_.assign(internal::kTraceMagic.begin(), internal::kTraceMagic.end());
+    PutVarint(component_sizes.size());
+    for (std::size_t size : component_sizes) {
+      PutVarint(size);
+    }
+  }
+
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  ~TraceWriter() { Flush(); }
+
+  void AddEntity(Entity entity) {
+    Put(TraceOp::kAddEntity);
+    PutVarint(entity.handle());
+  }
+
+  void RemoveEntity(Entity entity) {
+    Put(TraceOp::kRemoveEntity);
+    PutVarint(entity.handle());
+  }
+
+  void AddComponent(Entity entity, std::size_t component_type) {
+    Put(TraceOp::kAddComponent);
+    PutVarint(entity.handle());
+    PutVarint(component_type);
+  }
+
+  void RemoveComponent(Entity entity, std::size_t component_type) {
+    Put(TraceOp::kRemoveComponent);
+    PutVarint(entity.handle());
+    PutVarint(component_type);
+  }
+
+  void GetComponent(Entity entity, std::size_t component_type) {
+    Put(TraceOp::kGetComponent);
+    PutVarint(entity.handle());
+    PutVarint(component_type);
+  }
+
+  void Query(std::span<const std::size_t> component_ids) {
+    Put(TraceOp::kQuery);
+    PutVarint(component_ids.size());
+    for (std::size_t component_type : component_ids) {
+      PutVarint(component_type);
+    }
+  }
+
+  // Write the buffered records to the file.
+  void Flush() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    buffer_.clear();
+  }
+
+ private:
+  static constexpr std::size_t kBlockSize = 1 << 16;
+
+  void Put(TraceOp op) {
+    if (buffer_.size() >= kBlockSize) {
+      Flush();
+    }
+    buffer_.push_back(static_cast<char>(op));
+  }
+
+  void PutVarint(std::size_t value) {
+    while (value >= 0x80) {
+      buffer_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+  }
+
+  std::ofstream file_;
+  std::vector<char> buffer_;
+};
+
+// Reads traces written by TraceWriter. Malformed traces are reported with
+// std::runtime_error.
+class TraceReader final {
+ public:
+  explicit TraceReader(const std::filesystem::path &path)
+      : file_{path, std::ios::binary} {
+    if (!file_) {
+      throw std::runtime_error("Can't open trace " + path.string());
+    }
+    std::array<char, internal::kTraceMagic.size()> magic{};
+    file_.read(magic.data(), magic.size());
+    if (!file_ || magic != internal::kTraceMagic) {
+      throw std::runtime_error("Not a trace " + path.string());
+    }
+    component_sizes_.resize(GetVarint());
+    for (std::size_t &size : component_sizes_) {
+      size = GetVarint();
+    }
+  }
+
+  // Sizes of the components of the recorded world by type id.
+  std::span<const std::size_t> component_sizes() const noexcept {
+    return component_sizes_;
+  }
+
+  // Returns false at the end of the trace.
+  bool Next(TraceRecord &record) {
+    int op = file_.get();
+    if (op == std::ifstream::traits_type::eof()) {
+      return false;
+    }
+    if (op >= static_cast<int>(kNumTraceOps)) {
+      throw std::runtime_error("Unknown trace operation");
+    }
+    record.op = static_cast<TraceOp>(op);
+    switch (record.op) {
+      case TraceOp::kAddEntity:
+      case TraceOp::kRemoveEntity:
+        record.entity = GetVarint();
+        break;
+      case TraceOp::kAddComponent:
+      case TraceOp::kRemoveComponent:
+      case TraceOp::kGetComponent:
+        record.entity = GetVarint();
+        record.component = GetComponentType();
+        break;
+      case TraceOp::kQuery: {
+        std::size_t num_components = GetVarint();
+        if (num_components > component_sizes_.size()) {
+          throw std::runtime_error("Malformed trace query");
+        }
+        record.components.resize(num_components);
+        for (std::size_t &component_type : record.components) {
+          component_type = GetComponentType();
+        }
+        break;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::size_t GetVarint() {
+    std::size_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      int byte = file_.get();
+      if (byte == std::ifstream::traits_type::eof()) {
+        throw std::runtime_error("Truncated trace");
+      }
+      value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw std::runtime_error("Malformed trace");
+  }
+
+  std::size_t GetComponentType() {
+    std::size_t component_type = GetVarint();
+    if (component_type >= component_sizes_.size()) {
+      throw std::runtime_error("Unknown component type in trace");
+    }
+    return component_type;
+  }
+
+  std::ifstream file_;
+  std::vector<std::size_t> component_sizes_;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_TRACE_H_
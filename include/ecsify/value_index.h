@@ -0,0 +1,186 @@
+#ifndef ECSIFY_INCLUDE_ECSIFY_VALUE_INDEX_H_
+#define ECSIFY_INCLUDE_ECSIFY_VALUE_INDEX_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "ecsify/component_tracker.h"
+#include "ecsify/entity.h"
+
+namespace ecsify {
+
+namespace internal {
+
+template <auto kMember>
+struct MemberTraits;
+
+template <class C, class M, M C::*kMember>
+struct MemberTraits<kMember> {
+  using Class = C;
+  using Type = M;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Maps unique values of a component field to their entities.
+ *
+ * Register with WorldBuilder::Track<Component> to keep the index in sync: it
+ * follows additions, removals and tracked writes (World::Set and
+ * World::Modified). If several entities share a key, Find returns the last
+ * written one, and the others are found again once it loses the key.
+ *
+ * @tparam Component The indexed component.
+ * @tparam kMember Pointer to the indexed field, e.g. &PlayerId::value.
+ */
+template <class Component, auto kMember>
+class HashIndex final : public ComponentTracker<Component> {
+ public:
+  using Key = typename internal::MemberTraits<kMember>::Type;
+
+  void OnAdd(Entity entity, const Component &component) override {
+    Insert(entity, component.*kMember);
+  }
+
+  void OnSet(Entity entity, const Component &component) override {
+    const Key &key = component.*kMember;
+    // Rewriting the key makes the entity the last written again.
+    Erase(entity);
+    Insert(entity, key);
+  }
+
+  void OnRemove(Entity entity) override { Erase(entity); }
+
+  // Return the entity with the key or a default constructed one.
+  Entity Find(const Key &key) const {
+    auto it = entities_.find(key);
+    return it == entities_.end() ? Entity{} : it->second.back();
+  }
+
+  std::size_t Size() const noexcept { return entities_.size(); }
+
+ private:
+  void Insert(Entity entity, const Key &key) {
+    if (entity.handle() >= keys_.size()) {
+      keys_.resize(entity.handle() + 1);
+    }
+    keys_[entity.handle()] = key;
+    entities_[key].push_back(entity);
+  }
+
+  void Erase(Entity entity) {
+    if (entity.handle() >= keys_.size()) {
+      return;
+    }
+    std::optional<Key> &key = keys_[entity.handle()];
+    if (!key.has_value()) {
+      return;
+    }
+    auto it = entities_.find(*key);
+    std::vector<Entity> &sharing = it->second;
+    // Keys are rarely shared, so the linear search is short.
+    auto shared = std::ranges::find(sharing, entity);
+    assert(shared != sharing.end() && "Entity is missing from the index");
+    sharing.erase(shared);
+    if (sharing.empty()) {
+      entities_.erase(it);
+    }
+    key.reset();
+  }
+
+  // Entities having the key in the order they were written.
+  std::unordered_map<Key, std::vector<Entity>> entities_;
+  // Current key of every indexed entity by entity handle.
+  std::vector<std::optional<Key>> keys_;
+};
+
+/**
+ * @brief Groups entities by the value of a component field.
+ *
+ * Suits low-cardinality keys like teams or factions. Entities of a group are
+ * stored contiguously and in no particular order. The index is kept in sync
+ * the same way as HashIndex.
+ *
+ * @tparam Component The indexed component.
+ * @tparam kMember Pointer to the indexed field, e.g. &Team::value.
+ */
+template <class Component, auto kMember>
+class GroupIndex final : public ComponentTracker<Component> {
+ public:
+  using Key = typename internal::MemberTraits<kMember>::Type;
+
+  void OnAdd(Entity entity, const Component &component) override {
+    Insert(entity, component.*kMember);
+  }
+
+  void OnSet(Entity entity, const Component &component) override {
+    const Key &key = component.*kMember;
+    if (entity.handle() < locations_.size() &&
+        locations_[entity.handle()].key == key) {
+      return;
+    }
+    Erase(entity);
+    Insert(entity, key);
+  }
+
+  void OnRemove(Entity entity) override { Erase(entity); }
+
+  std::span<const Entity> Find(const Key &key) const {
+    auto it = groups_.find(key);
+    if (it == groups_.end()) {
+      return {};
+    }
+    return it->second;
+  }
+
+  std::size_t NumGroups() const noexcept { return groups_.size(); }
+
+ private:
+  struct Location {
+    std::optional<Key> key;
+    std::size_t idx{};
+  };
+
+  void Insert(Entity entity, const Key &key) {
+    if (entity.handle() >= locations_.size()) {
+      locations_.resize(entity.handle() + 1);
+    }
+    std::vector<Entity> &group = groups_[key];
+    locations_[entity.handle()] = Location{.key = key, .idx = group.size()};
+    group.push_back(entity);
+  }
+
+  void Erase(Entity entity) {
+    if (entity.handle() >= locations_.size()) {
+      return;
+    }
+    Location &location = locations_[entity.handle()];
+    if (!location.key.has_value()) {
+      return;
+    }
+    auto group_it = groups_.find(*location.key);
+    std::vector<Entity> &group = group_it->second;
+    // Swap with the last entity to erase in O(1).
+    Entity last = group.back();
+    locations_[last.handle()].idx = location.idx;
+    group[location.idx] = last;
+    group.pop_back();
+    if (group.empty()) {
+      groups_.erase(group_it);
+    }
+    location.key.reset();
+  }
+
+  std::unordered_map<Key, std::vector<Entity>> groups_;
+  // Group and position inside it of every indexed entity by entity handle.
+  std::vector<Location> locations_;
+};
+
+}  // namespace ecsify
+
+#endif  // ECSIFY_INCLUDE_ECSIFY_VALUE_INDEX_H_
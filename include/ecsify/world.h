@@ -2,15 +2,63 @@
 #define ECSIFY_INCLUDE_ECSIFY_WORLD_H_
 
 #include <array>
+#include <cassert>
 #include <cstddef>
-#include <ranges>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include "ecsify/component.h"
 #include "ecsify/entity.h"
+#include "ecsify/event_channel.h"
+#include "ecsify/hierarchy.h"
+#include "ecsify/query.h"
+#include "ecsify/region.h"
+#include "ecsify/resource.h"
+#include "ecsify/schedule.h"
+#include "ecsify/shared.h"
+#include "ecsify/snapshot.h"
 
 namespace ecsify {
 
+namespace internal {
+
+class ReplayAccess;
+
+// Row of an entity located by World::Get or World::GetMany.
+struct Row {
+  // Storages of the archetype indexed by component type, see
+  // ComponentPoolBase::Column. Only the requested ones are set.
+  void *const *columns;
+  std::size_t handle;
+  // Position of the entity in the list passed to World::GetMany.
+  std::size_t index;
+};
+
+template <class Component>
+using RowPool = std::conditional_t<
+    std::is_const_v<Component>,
+    const DataPool<std::remove_const_t<Component>>,
+    DataPool<std::remove_const_t<Component>>>;
+
+template <class Component>
+Component &At(const Row &row) {
+  return (*static_cast<RowPool<Component> *>(
+      row.columns[Component::TypeID()]))[row.handle];
+}
+
+template <class Component>
+void Prefetch(const Row &row) {
+  static_cast<const RowPool<Component> *>(row.columns[Component::TypeID()])
+      ->Prefetch(row.handle);
+}
+
+}  // namespace internal
+
 class World {
  public:
   // Create new entity.
@@ -20,6 +68,77 @@ class World {
   // Check if entity is alive.
   virtual bool Alive(Entity entity) const = 0;
 
+  // Create a prefab: an entity serving as a template, which is skipped by
+  // queries. Its components are added and set as usual.
+  virtual Entity AddPrefab() = 0;
+  // Create count entities with copies of all the prefab components. Every
+  // component is copied into its storage in bulk.
+  virtual std::vector<Entity> Instantiate(Entity prefab,
+                                          std::size_t count) = 0;
+
+  // Reserve an entity. Unlike the rest of the world, it's safe to call from
+  // any thread concurrently with anything else. The entity becomes alive on
+  // the next Flush.
+  virtual Entity ReserveEntity() = 0;
+  // Reserve several entities at once, see ReserveEntity.
+  virtual std::vector<Entity> ReserveEntities(std::size_t count) = 0;
+  // Make the entities reserved so far alive. Called by Update before running
+  // the systems.
+  virtual void Flush() = 0;
+
+  // Move the entities with all their components into the destination world,
+  // which must be built with the same components. Returns the new entities in
+  // the same order. Hierarchy relations of the moved entities are dropped.
+  virtual std::vector<Entity> Migrate(std::span<const Entity> entities,
+                                      World &destination) = 0;
+
+  // Create an empty region. Its id is reused once it's unloaded.
+  virtual Region AddRegion() = 0;
+  // Create new entity in the region. Adding and removing components keeps it
+  // there.
+  virtual Entity Add(Region region) = 0;
+  // Write the components of the region entities to the file. All of them must
+  // be trivially copyable. Entity ids and hierarchy relations aren't saved,
+  // and components are loaded enabled.
+  virtual void SaveRegion(Region region,
+                          const std::filesystem::path &path) const = 0;
+  // Read a file written by SaveRegion. Unlike the rest of the world, it's safe
+  // to call from any thread concurrently with anything else, so the region
+  // can be prepared in the background.
+  virtual RegionChunk PrepareRegion(
+      const std::filesystem::path &path) const = 0;
+  // Splice the prepared entities into a new region. The storages are handed
+  // over as a whole, so only the entity ids are created one by one.
+  virtual Region LoadRegion(RegionChunk chunk) = 0;
+  // Remove all the entities of the region, dropping its archetypes as a
+  // whole.
+  virtual void UnloadRegion(Region region) = 0;
+
+  // Start a fork of the entities, their components and the hierarchy. The
+  // world can be rolled back to any of the last forks, see
+  // WorldBuilder::Rollback. Storages and the hierarchy are journaled in
+  // blocks: a block is copied when it's first reached mutably after the fork
+  // (e.g. by Get or by a query of non-const components), so a fork costs
+  // nothing upfront and a tick pays for the blocks it changes. Returns the id
+  // of the fork.
+  virtual std::uint64_t Fork() = 0;
+  // Restore the entities, their components and the hierarchy as of the fork
+  // dropping the later forks. Journaled component blocks are swapped back in
+  // rather than copied. Resources, events and systems are left as is.
+  virtual void Rollback(std::uint64_t fork) = 0;
+
+  // Make parent the parent of child. Removing an entity detaches it from its
+  // parent and turns its children into roots.
+  virtual void SetParent(Entity child, Entity parent) = 0;
+  // Detach the child from its parent.
+  virtual void RemoveParent(Entity child) = 0;
+  // Return the parent of the entity or a default constructed one for roots.
+  virtual Entity Parent(Entity child) const = 0;
+  virtual std::span<const Entity> Children(Entity parent) const = 0;
+  // Return all the entities having a parent or children in breadth-first
+  // order, so every parent precedes its children.
+  virtual std::span<const HierarchyNode> Hierarchy() = 0;
+
   // Add component to the entity.
   template <class Component>
     requires(!std::is_same_v<Component, Entity>)
@@ -38,6 +157,68 @@ class World {
     return static_cast<const Component &>(Get(entity, Component::TypeID()));
   }
 
+  // Get several components of the entity at once. The entity and its
+  // archetype are looked up once for all of them. Components only read should
+  // be const, see QueryView.
+  template <class... Components>
+    requires(sizeof...(Components) > 1 &&
+             (!std::is_same_v<Components, Entity> && ...))
+  std::tuple<Components &...> Get(Entity entity) {
+    std::array<std::size_t, sizeof...(Components)> component_ids = {
+        Components::TypeID()...};
+    internal::Row row = Locate(entity, component_ids);
+    return {internal::At<Components>(row)...};
+  }
+
+  // Get the components of every entity, e.g. to resolve references held by
+  // other components. Rows are looked up grouped by archetype in storage
+  // order with the next ones prefetched, so the memory is walked mostly
+  // sequentially. Returns the components in the order of the entities.
+  template <class... Components>
+    requires(sizeof...(Components) > 0 &&
+             (!std::is_same_v<Components, Entity> && ...))
+  std::vector<std::tuple<Components &...>> GetMany(
+      std::span<const Entity> entities) {
+    // Rows prefetched ahead of the one being read.
+    constexpr std::size_t kPrefetchDistance = 8;
+    std::array<std::size_t, sizeof...(Components)> component_ids = {
+        Components::TypeID()...};
+    std::vector<internal::Row> rows;
+    LocateMany(entities, component_ids, rows);
+    std::vector<std::tuple<Components *...>> found(entities.size());
+    for (std::size_t idx = 0; idx < rows.size(); ++idx) {
+      if (idx + kPrefetchDistance < rows.size()) {
+        (internal::Prefetch<Components>(rows[idx + kPrefetchDistance]), ...);
+      }
+      found[rows[idx].index] = {&internal::At<Components>(rows[idx])...};
+    }
+    std::vector<std::tuple<Components &...>> result;
+    result.reserve(found.size());
+    for (const std::tuple<Components *...> &components : found) {
+      std::apply(
+          [&result](Components *...component) {
+            result.emplace_back(*component...);
+          },
+          components);
+    }
+    return result;
+  }
+
+  // Write the component and notify its trackers.
+  template <class Component>
+    requires(!std::is_same_v<Component, Entity>)
+  void Set(Entity entity, const Component &value) {
+    Get<Component>(entity) = value;
+    Modified(entity, Component::TypeID());
+  }
+
+  // Notify trackers of the component that it was modified in place.
+  template <class Component>
+    requires(!std::is_same_v<Component, Entity>)
+  void Modified(Entity entity) {
+    Modified(entity, Component::TypeID());
+  }
+
   // Check if an entity has the component.
   template <class Component>
   bool Has(Entity entity) {
@@ -50,38 +231,215 @@ class World {
     Remove(entity, Component::TypeID());
   }
 
+  // Disable the component of the entity without moving it to another
+  // archetype: only a bit of its row is flipped. Queries skip the entity
+  // while any of their components is disabled, but Get and Has still see the
+  // component. The bit moves with the row when other components are added or
+  // removed, and is reset when the component itself is removed.
+  template <class Component>
+    requires(!std::is_same_v<Component, Entity>)
+  void Disable(Entity entity) {
+    SetEnabled(entity, Component::TypeID(), false);
+  }
+
+  // Enable the component disabled by Disable.
+  template <class Component>
+    requires(!std::is_same_v<Component, Entity>)
+  void Enable(Entity entity) {
+    SetEnabled(entity, Component::TypeID(), true);
+  }
+
+  template <class Component>
+  bool Enabled(Entity entity) const {
+    return Enabled(entity, Component::TypeID());
+  }
+
+  // Set the value of the shared component of the entity adding the component
+  // if needed, see WorldBuilder::Shared. Entities with equal values share a
+  // single copy of it, so changing the value moves the entity between
+  // archetypes like adding a component does.
+  template <class Component>
+    requires(!std::is_same_v<Component, Entity>)
+  void SetShared(Entity entity, const Component &value) {
+    SetShared(entity, Component::TypeID(), value);
+  }
+
+  // The value of the shared component of the entity, see SetShared.
+  template <class Component>
+  const Component &GetShared(Entity entity) const {
+    return static_cast<const Component &>(
+        GetShared(entity, Component::TypeID()));
+  }
+
+  // Remove every entity which has all the Filter components. Matching
+  // archetypes are dropped as a whole instead of entity by entity.
+  template <class... Filter>
+  void RemoveAll() {
+    std::array<std::size_t, sizeof...(Filter)> component_ids = {
+        Filter::TypeID()...};
+    RemoveAll(component_ids);
+  }
+
+  // Add the Component to every entity having all the Filter components and
+  // lacking it. Rows of every matching archetype move in bulk, and storages
+  // are relabeled without copying when the destination archetype is empty.
+  template <class Component, class... Filter>
+    requires(!std::is_same_v<Component, Entity>)
+  void AddToAll() {
+    std::array<std::size_t, sizeof...(Filter)> component_ids = {
+        Filter::TypeID()...};
+    AddToAll(Component::TypeID(), component_ids);
+  }
+
+  // Remove the Component from every entity having it and all the Filter
+  // components, see AddToAll.
+  template <class Component, class... Filter>
+    requires(!std::is_same_v<Component, Entity>)
+  void RemoveFromAll() {
+    std::array<std::size_t, sizeof...(Filter)> component_ids = {
+        Filter::TypeID()...};
+    RemoveFromAll(Component::TypeID(), component_ids);
+  }
+
+  // Channel of the event type registered with WorldBuilder::Event.
+  template <class Event>
+  EventChannel<Event> &Events() {
+    return static_cast<EventChannel<Event> &>(
+        Channel(internal::EventTypeID<Event>()));
+  }
+
+  // The world-global instance of the type registered with
+  // WorldBuilder::Resource. Access is a non-virtual array lookup. Systems only
+  // reading the resource should ask for Resource<const T>.
+  template <class T>
+  T &Resource() {
+    return *static_cast<T *>(
+        FindResource(internal::ResourceTypeID<std::remove_const_t<T>>()));
+  }
+
+  template <class T>
+  const T &Resource() const {
+    return *static_cast<const T *>(
+        FindResource(internal::ResourceTypeID<std::remove_const_t<T>>()));
+  }
+
+  // The T components as of the end of the last Update, registered with
+  // WorldBuilder::Snapshot. Thread-safe, so other threads can read the
+  // snapshot while the world runs the next tick.
+  template <class T>
+    requires(!std::is_same_v<T, Entity>)
+  std::shared_ptr<const ComponentSnapshot<T>> Snapshot() const {
+    return static_cast<const internal::SnapshotBuffer<T> &>(
+               Snapshots(T::TypeID()))
+        .Latest();
+  }
+
   template <class... Components>
-  auto Query() {
+  QueryView<Components...> Query() {
     std::array<std::size_t, sizeof...(Components)> component_ids = {
         Components::TypeID()...};
-    return std::views::zip(CastQuery<Components>(
-        QueryOne(Components::TypeID(), component_ids))...);
+    return QueryView<Components...>{
+        {QueryOne(Components::TypeID(), component_ids)...}};
+  }
+
+  // Rows of the entities having all the Components grouped by the value of
+  // the Shared component, see SharedGroups. Shared components can't be
+  // queried with Query.
+  template <class Shared, class... Components>
+  SharedGroups<Shared, Components...> QueryShared() {
+    std::array<std::size_t, 1 + sizeof...(Components)> component_ids = {
+        Shared::TypeID(), Components::TypeID()...};
+    return SharedGroups<Shared, Components...>{QueryGroups(component_ids)};
   }
 
+  // Write the components stored in files (see WorldBuilder::PageToFiles) to
+  // the files, and the rest of the world next to them if it can be restored.
+  virtual void Sync() = 0;
+
+  // Deliver the changes recorded since the previous call to the observers
+  // registered with WorldBuilder::Observe. Called by Update before running the
+  // systems.
+  virtual void Notify() = 0;
+
+  // Reorder rows changed since the previous call by the keys registered with
+  // WorldBuilder::SortBy. Called by Update before running the systems.
+  virtual void Sort() = 0;
+
+  // Run the systems. Time since the previous call is measured with a steady
+  // clock and is zero on the first call.
   virtual void Update() = 0;
+  // Run the systems simulating the time passed since the previous tick.
+  virtual void Update(Duration delta_time) = 0;
+  // Time step of the running system group: the fixed step of fixed-step
+  // groups or the time since the group last ran otherwise.
+  virtual Duration DeltaTime() const = 0;
 
   virtual ~World() = default;
 
  protected:
+  // Plays traces back through the untyped interface.
+  friend class internal::ReplayAccess;
+
   virtual void Add(Entity entity, std::size_t component_type) = 0;
   virtual void Remove(Entity entity, std::size_t component_type) = 0;
   virtual bool Has(Entity entity, std::size_t component_type) const = 0;
+  virtual void RemoveAll(std::span<std::size_t> component_ids) = 0;
+  virtual void AddToAll(std::size_t component_type,
+                        std::span<std::size_t> component_ids) = 0;
+  virtual void RemoveFromAll(std::size_t component_type,
+                             std::span<std::size_t> component_ids) = 0;
   virtual internal::ComponentBase &Get(Entity entity,
                                        std::size_t component_type) = 0;
   virtual const internal::ComponentBase &Get(
       Entity entity, std::size_t component_type) const = 0;
+  virtual void Modified(Entity entity, std::size_t component_type) = 0;
+  // Returns the row of the entity with the storages of the components set.
+  virtual internal::Row Locate(Entity entity,
+                               std::span<std::size_t> component_ids) = 0;
+  // Replaces the rows with the ones of the entities sorted by archetype and
+  // handle, see Locate.
+  virtual void LocateMany(std::span<const Entity> entities,
+                          std::span<std::size_t> component_ids,
+                          std::vector<internal::Row> &rows) = 0;
+  virtual void SetEnabled(Entity entity, std::size_t component_type,
+                          bool enabled) = 0;
+  virtual bool Enabled(Entity entity, std::size_t component_type) const = 0;
+  virtual void SetShared(Entity entity, std::size_t component_type,
+                         const internal::ComponentBase &value) = 0;
+  virtual const internal::ComponentBase &GetShared(
+      Entity entity, std::size_t component_type) const = 0;
 
-  virtual std::span<internal::ComponentBase *> QueryOne(
+  virtual internal::EventChannelBase &Channel(std::size_t event_type) = 0;
+  virtual const internal::SnapshotBufferBase &Snapshots(
+      std::size_t component_type) const = 0;
+  // Make the resource of the type found by Resource, see
+  // internal::ResourceTypeID. The world doesn't own it.
+  void SetResource(std::size_t resource_type, void *resource) {
+    if (resources_.size() <= resource_type) {
+      resources_.resize(resource_type + 1);
+    }
+    resources_[resource_type] = resource;
+  }
+
+  // Returns storages of the component in the archetypes having all the
+  // components, see QueryView::Columns.
+  virtual std::span<void *const> QueryOne(
       std::size_t component_type, std::span<std::size_t> component_ids) = 0;
+  // Returns the archetypes having all the components grouped by the value of
+  // the first one, which is shared. Columns of every group follow the order
+  // of the rest of the components.
+  virtual std::span<const internal::SharedGroup> QueryGroups(
+      std::span<std::size_t> component_ids) = 0;
 
  private:
-  template <class Component>
-  static auto CastQuery(std::span<internal::ComponentBase *> query) {
-    return query | std::views::transform(
-                       [](internal::ComponentBase *component) -> Component & {
-                         return *static_cast<Component *>(component);
-                       });
+  void *FindResource(std::size_t resource_type) const noexcept {
+    assert(resource_type < resources_.size() &&
+           resources_[resource_type] != nullptr && "Unknown resource");
+    return resources_[resource_type];
   }
+
+  // Indexed by resource type ids, null for resources the world lacks.
+  std::vector<void *> resources_;
 };
 
 }  // namespace ecsify
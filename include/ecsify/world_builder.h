@@ -2,15 +2,30 @@
 #define ECSIFY_INCLUDE_ECSIFY_WORLD_BUILDER_H_
 
 #include <array>
+#include <cassert>
+#include <concepts>
 #include <cstddef>
+#include <filesystem>
+#include <initializer_list>
 #include <memory>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "ecsify/component_observer.h"
+#include "ecsify/component_tracker.h"
 #include "ecsify/entity.h"
+#include "ecsify/event_channel.h"
 #include "ecsify/internal/component_pool.h"
+#include "ecsify/internal/shared_pool.h"
 #include "ecsify/internal/world_impl.h"
+#include "ecsify/resource.h"
+#include "ecsify/schedule.h"
+#include "ecsify/sharded_world.h"
+#include "ecsify/snapshot.h"
+#include "ecsify/task.h"
 
 namespace ecsify {
 
@@ -35,10 +50,9 @@ constexpr bool sequential_components_v =
                    std::index_sequence_for<Components...>>::value;
 
 template <class... Components>
-auto MakeComponentPools() -> std::array<ComponentPoolRef<sizeof...(Components)>,
-                                        sizeof...(Components)> {
-  return {
-      std::make_unique<ComponentPool<Components, sizeof...(Components)>>()...};
+auto MakeComponentPools()
+    -> std::array<ComponentPoolRef, sizeof...(Components)> {
+  return {std::make_unique<ComponentPool<Components>>()...};
 }
 
 }  // namespace internal
@@ -50,28 +64,224 @@ template <class... Components>
 class WorldBuilder final {
  public:
   WorldBuilder() {}
-  explicit WorldBuilder(std::vector<internal::SystemFunctionType> systems)
-      : systems_{std::move(systems)} {}
+  explicit WorldBuilder(internal::WorldConfig config)
+      : config_{std::move(config)} {}
 
   template <class T>
   WorldBuilder<Components..., T> Component() noexcept {
-    return WorldBuilder<Components..., T>{std::move(systems_)};
+    return WorldBuilder<Components..., T>{std::move(config_)};
   }
 
+  // Register a system run on every tick in the phase. Systems returning Task
+  // are coroutines resumed on every run, see Task.
   template <class T>
-  WorldBuilder &System(T &&system) {
-    systems_.emplace_back(std::forward<T>(system));
+  WorldBuilder &System(T &&system, Phase phase = Phase::kUpdate) {
+    config_.systems.push_back(internal::SystemConfig{
+        .function = MakeSystem(std::forward<T>(system)), .phase = phase});
+    return *this;
+  }
+
+  // Register a system run with the group.
+  template <class T>
+  WorldBuilder &System(T &&system, std::string group) {
+    config_.systems.push_back(
+        internal::SystemConfig{.function = MakeSystem(std::forward<T>(system)),
+                               .group = std::move(group)});
+    return *this;
+  }
+
+  // Declare a group of systems run in the phase at its own rate. Steps and
+  // divisors must be positive.
+  WorldBuilder &Group(std::string name, Rate rate,
+                      Phase phase = Phase::kUpdate) {
+    assert((!std::holds_alternative<FixedStep>(rate) ||
+            std::get<FixedStep>(rate).step > Duration::zero()) &&
+           "Fixed step must be positive");
+    assert((!std::holds_alternative<TickDivisor>(rate) ||
+            std::get<TickDivisor>(rate).divisor != 0) &&
+           "Tick divisor must be positive");
+    config_.groups.push_back(internal::GroupConfig{
+        .name = std::move(name), .rate = rate, .phase = phase});
+    return *this;
+  }
+
+  // Register a channel of the events of type T, see World::Events.
+  template <class T>
+  WorldBuilder &Event() {
+    config_.events.emplace_back(
+        internal::EventTypeID<T>(), []() -> internal::EventChannelRef {
+          return std::make_unique<EventChannel<T>>();
+        });
+    return *this;
+  }
+
+  // Register a world-global resource initialized with the value, see
+  // World::Resource. Every built world gets its own copy.
+  template <class T>
+  WorldBuilder &Resource(T value = T{}) {
+    config_.resources.emplace_back(
+        internal::ResourceTypeID<T>(),
+        [value = std::move(value)]() -> std::shared_ptr<void> {
+          return std::make_shared<T>(value);
+        });
+    return *this;
+  }
+
+  // Publish copies of the T components at the end of every Update for
+  // reader threads, see World::Snapshot. Every Update refills a spare buffer
+  // with the buckets of rows written since the buffer was last published and
+  // swaps it in, so steady ticks cost O(changed buckets). Disabled
+  // components are left out, like queries skip them.
+  template <class T>
+    requires(std::is_copy_constructible_v<T>)
+  WorldBuilder &Snapshot() {
+    config_.snapshots.emplace_back(
+        T::TypeID(), []() -> internal::SnapshotBufferRef {
+          return std::make_unique<internal::SnapshotBuffer<T>>();
+        });
+    return *this;
+  }
+
+  // Store the T components in memory-mapped files in the directory, one per
+  // archetype, so the OS can page out the cold ones. On their own, the files
+  // only back the memory and are overwritten by every built world, see the
+  // overload below for restoring a world. Components stay on the heap on
+  // other systems than Linux.
+  template <class T>
+    requires(std::is_trivially_copyable_v<T>)
+  WorldBuilder &PageToFiles(std::filesystem::path directory) {
+    config_.mapped.emplace_back(T::TypeID(), std::move(directory));
+    return *this;
+  }
+
+  // Store all the trivially copyable components in memory-mapped files in
+  // subdirectories of the directory named by component type ids. If all of
+  // them are stored in files, World::Sync also saves the entities, the
+  // archetypes, the regions and the hierarchy in the directory, and a world
+  // built later over it is restored as of the last Sync. The world syncs
+  // when destroyed too. Trackers and observers aren't notified about the
+  // restored components, and shared components can't be restored. Building
+  // throws std::runtime_error if the files were changed after the last Sync,
+  // e.g. by a crash.
+  WorldBuilder &PageToFiles(const std::filesystem::path &directory) {
+    for (std::size_t component_type :
+         {Entity::TypeID(), Components::TypeID()...}) {
+      config_.mapped.emplace_back(component_type,
+                                  directory / std::to_string(component_type));
+    }
+    config_.state = directory / "world.state";
+    return *this;
+  }
+
+  // Record the entity and component calls into a binary trace written to
+  // the file, see TraceWriter. benchmarks/trace_replay.cc plays it back.
+  WorldBuilder &RecordTrace(std::filesystem::path path) {
+    config_.trace = std::move(path);
+    return *this;
+  }
+
+  // Keep the rarely used fields of the Hot component in the Cold one. Both
+  // are stored in columns of their own and queried independently, so
+  // iterating Hot doesn't drag the cold bytes through the cache, but adding
+  // or removing either adds or removes both in a single migration.
+  template <class Hot, class Cold>
+    requires(!std::is_same_v<Hot, Entity> && !std::is_same_v<Cold, Entity>)
+  WorldBuilder &Split() {
+    config_.splits.emplace_back(Hot::TypeID(), Cold::TypeID());
+    return *this;
+  }
+
+  // Store the T components once per distinct value instead of once per
+  // entity, see World::SetShared. Entities are grouped into archetypes by the
+  // value, so World::QueryShared visits them group by group. Values are kept
+  // for the lifetime of the world. Shared components can't be tracked,
+  // observed, split, sorted by or published as snapshots.
+  template <class T>
+    requires(!std::is_same_v<T, Entity> && std::equality_comparable<T>)
+  WorldBuilder &Shared() {
+    config_.shared.emplace_back(T::TypeID(), []() -> internal::SharedPoolRef {
+      return std::make_unique<internal::SharedPool<T>>();
+    });
+    return *this;
+  }
+
+  // Journal the changes of the storages, so that the world can be rolled
+  // back to any of the last depth forks, see World::Fork. Trackers, observers
+  // and files aren't rolled back, so they can't be used together.
+  WorldBuilder &Rollback(std::size_t depth) {
+    config_.rollback_depth = depth;
+    return *this;
+  }
+
+  // Register a tracker notified about changes of the T component.
+  template <class T>
+  WorldBuilder &Track(std::shared_ptr<ComponentTracker<T>> tracker) {
+    config_.trackers.emplace_back(T::TypeID(), std::move(tracker));
+    return *this;
+  }
+
+  // Register an observer receiving batched changes of the T component.
+  template <class T>
+  WorldBuilder &Observe(std::shared_ptr<ComponentObserver<T>> observer) {
+    config_.observers.emplace_back(T::TypeID(), std::move(observer));
+    return *this;
+  }
+
+  // Keep rows of every archetype with the T component ordered by key(T), so
+  // queries visit them sequentially grouped by the key. Archetypes holding
+  // several keyed components are ordered by the key registered first.
+  template <class T, class Key>
+  WorldBuilder &SortBy(Key key) {
+    config_.sort_keys.emplace_back(
+        T::TypeID(),
+        [key = std::move(key)](const internal::ComponentBase &lhs,
+                               const internal::ComponentBase &rhs) {
+          return key(static_cast<const T &>(lhs)) <
+                 key(static_cast<const T &>(rhs));
+        });
     return *this;
   }
 
   std::unique_ptr<World> Build() {
+    assert((config_.rollback_depth == 0 ||
+            (config_.trackers.empty() && config_.observers.empty() &&
+             config_.mapped.empty())) &&
+           "Trackers, observers and files can't be rolled back");
+    config_.component_sizes = {sizeof(Entity), sizeof(Components)...};
     return std::make_unique<internal::WorldImpl<1 + sizeof...(Components)>>(
         internal::MakeComponentPools<Entity, Components...>(),
-        std::move(systems_));
+        std::move(config_));
+  }
+
+  // Build several worlds with the same components and systems, run by
+  // workers placed on the machine as requested.
+  std::unique_ptr<ShardedWorld> BuildShards(
+      std::size_t num_shards, Placement placement = Placement::kAny) {
+    assert(config_.trackers.empty() && config_.observers.empty() &&
+           "Trackers and observers can't be shared between shards");
+    assert(config_.mapped.empty() && !config_.trace.has_value() &&
+           "Files can't be shared between shards");
+    std::vector<std::unique_ptr<World>> shards;
+    shards.reserve(num_shards);
+    for (std::size_t idx = 0; idx < num_shards; ++idx) {
+      shards.push_back(
+          std::make_unique<internal::WorldImpl<1 + sizeof...(Components)>>(
+              internal::MakeComponentPools<Entity, Components...>(), config_));
+    }
+    return std::make_unique<ShardedWorld>(std::move(shards), placement);
   }
 
  private:
-  std::vector<internal::SystemFunctionType> systems_;
+  template <class T>
+  static internal::SystemFunctionType MakeSystem(T &&system) {
+    if constexpr (std::is_same_v<std::invoke_result_t<T &, World &>, Task>) {
+      return internal::CoroutineSystem{std::forward<T>(system)};
+    } else {
+      return std::forward<T>(system);
+    }
+  }
+
+  internal::WorldConfig config_;
 };
 
 }  // namespace ecsify
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/component_observer.h"
+#include "ecsify/entity.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Body : ecsify::ComponentMixin<1> {
+  int mass;
+};
+
+struct Frozen : ecsify::ComponentMixin<2> {};
+
+class BodyObserver final : public ecsify::ComponentObserver<Body> {
+ public:
+  void OnAdd(ecsify::World &,
+             std::span<const ecsify::Entity> entities) override {
+    added.push_back(entities.size());
+  }
+
+  void OnSet(ecsify::World &world,
+             std::span<const ecsify::Entity> entities) override {
+    set.push_back(entities.size());
+    for (ecsify::Entity entity : entities) {
+      masses.push_back(world.Get<Body>(entity).mass);
+    }
+  }
+
+  void OnRemove(ecsify::World &,
+                std::span<const ecsify::Entity> entities) override {
+    removed.push_back(entities.size());
+  }
+
+  std::vector<std::size_t> added;
+  std::vector<std::size_t> set;
+  std::vector<std::size_t> removed;
+  std::vector<int> masses;
+};
+
+}  // namespace
+
+TEST(ComponentObserverTests, BatchesPerTransition) {
+  auto observer = std::make_shared<BodyObserver>();
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Body>()
+                   .Component<Frozen>()
+                   .Observe<Body>(observer)
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 10; ++i) {
+    ecsify::Entity entity = world->Add();
+    if (i >= 6) {
+      world->Add<Frozen>(entity);
+    }
+    entities.push_back(entity);
+  }
+  for (ecsify::Entity entity : entities) {
+    world->Add<Body>(entity);
+  }
+  ASSERT_TRUE(observer->added.empty());
+  world->Notify();
+  ASSERT_EQ(observer->added, (std::vector<std::size_t>{6, 4}));
+  world->Notify();
+  ASSERT_EQ(observer->added.size(), 2);
+
+  world->Set(entities[0], Body{.mass = 3});
+  world->Set(entities[1], Body{.mass = 4});
+  world->Remove<Frozen>(entities[9]);
+  world->Remove(entities[2]);
+  world->Remove(entities[3]);
+  world->Remove<Body>(entities[4]);
+  world->Update();
+  ASSERT_EQ(observer->set, std::vector<std::size_t>{2});
+  ASSERT_EQ(observer->masses, (std::vector<int>{3, 4}));
+  ASSERT_EQ(observer->removed, (std::vector<std::size_t>{2, 1}));
+  ASSERT_EQ(observer->added.size(), 2);
+}
+
+TEST(ComponentObserverTests, BulkOperations) {
+  auto observer = std::make_shared<BodyObserver>();
+  auto world =
+      ecsify::WorldBuilder{}.Component<Body>().Observe<Body>(observer).Build();
+  ecsify::Entity prefab = world->AddPrefab();
+  world->Add<Body>(prefab);
+  world->Instantiate(prefab, 100);
+  world->RemoveAll<Body>();
+  world->Notify();
+  ASSERT_EQ(observer->added, (std::vector<std::size_t>{1, 100}));
+  ASSERT_EQ(observer->removed, std::vector<std::size_t>{100});
+}
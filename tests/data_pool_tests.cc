@@ -1,10 +1,14 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <iterator>
 #include <ranges>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "ecsify/internal/data_pool.h"
@@ -263,3 +267,194 @@ TEST(DataPoolTests, Stability) {
   }
   ASSERT_TRUE(std::ranges::equal(pool1, pool2));
 }
+
+TEST(DataPoolTests, FillsBucketsBeforeAllocating) {
+  constexpr std::size_t kCapacity = ecsify::internal::Bucket<int>::Capacity();
+  ecsify::internal::DataPool<int> pool{};
+  for (std::size_t i = 0; i < kCapacity; ++i) {
+    ASSERT_EQ(pool.Insert(), i);
+  }
+  ASSERT_EQ(pool.Insert(), kCapacity);
+  pool.Erase(3);
+  ASSERT_EQ(pool.Insert(), 3);
+}
+
+TEST(DataPoolTests, IterationSkipsEmptyBuckets) {
+  constexpr std::size_t kCapacity =
+      ecsify::internal::Bucket<std::size_t>::Capacity();
+  ecsify::internal::DataPool<std::size_t> pool{};
+  for (std::size_t i = 0; i < 3 * kCapacity; ++i) {
+    pool[pool.Insert()] = i;
+  }
+  for (std::size_t i = 0; i < kCapacity; ++i) {
+    pool.Erase(i);
+    pool.Erase(2 * kCapacity + i);
+  }
+  ASSERT_EQ(std::ranges::distance(pool), kCapacity);
+  for (std::size_t val : pool) {
+    ASSERT_GE(val, kCapacity);
+    ASSERT_LT(val, 2 * kCapacity);
+  }
+  pool.Clear();
+  ASSERT_EQ(std::ranges::distance(pool), 0);
+  ASSERT_FALSE(pool.Contains(kCapacity));
+}
+
+TEST(DataPoolTests, Permute) {
+  ecsify::internal::DataPool<int> pool{};
+  for (int i = 0; i < 200; ++i) {
+    pool[pool.Insert()] = i;
+  }
+  for (std::size_t idx = 0; idx < 200; idx += 3) {
+    pool.Erase(idx);
+  }
+  std::vector<std::size_t> order = pool.Indices();
+  ASSERT_TRUE(std::ranges::all_of(
+      order, [&](std::size_t idx) { return pool.Contains(idx); }));
+  std::ranges::reverse(order);
+  pool.Permute(order);
+  std::vector<int> expected;
+  for (std::size_t idx : order) {
+    expected.push_back(static_cast<int>(idx));
+  }
+  ASSERT_TRUE(std::ranges::equal(pool, expected));
+  for (std::size_t idx = 0; idx < order.size(); ++idx) {
+    ASSERT_EQ(pool[idx], expected[idx]);
+  }
+  ASSERT_FALSE(pool.Contains(order.size()));
+}
+
+TEST(DataPoolTests, FillTakesSlotsLikeInsert) {
+  constexpr std::size_t kCapacity = ecsify::internal::Bucket<int>::Capacity();
+  ecsify::internal::DataPool<int> filled{};
+  ecsify::internal::DataPool<int> inserted{};
+  for (std::size_t i = 0; i < kCapacity + 2; ++i) {
+    filled.Insert();
+    inserted.Insert();
+  }
+  filled.Erase(5);
+  inserted.Erase(5);
+  std::vector<std::size_t> handles;
+  filled.Fill(7, 2 * kCapacity, &handles);
+  ASSERT_EQ(handles.size(), 2 * kCapacity);
+  for (std::size_t handle : handles) {
+    ASSERT_EQ(inserted.Insert(), handle);
+    ASSERT_EQ(filled[handle], 7);
+  }
+  ASSERT_EQ(filled.Insert(), inserted.Insert());
+}
+
+TEST(DataPoolTests, DenseWithoutGaps) {
+  constexpr std::size_t kCapacity = ecsify::internal::Bucket<int>::Capacity();
+  ecsify::internal::DataPool<int> pool{};
+  ASSERT_TRUE(pool.Dense());
+  for (std::size_t i = 0; i < kCapacity + 3; ++i) {
+    pool.Insert();
+  }
+  ASSERT_TRUE(pool.Dense());
+  pool.Erase(kCapacity + 2);
+  ASSERT_TRUE(pool.Dense());
+  pool.Erase(3);
+  ASSERT_FALSE(pool.Dense());
+  pool.Insert();
+  pool.Erase(kCapacity);
+  ASSERT_FALSE(pool.Dense());
+}
+
+TEST(DataPoolTests, JournaledPoolRollsBack) {
+  ecsify::internal::ForkClock clock{.depth = 2};
+  ecsify::internal::DataPool<int> pool{};
+  pool.Journal(&clock);
+  for (int i = 0; i < 100; ++i) {
+    pool[pool.Insert()] = i;
+  }
+  std::vector<int> forked(pool.begin(), pool.end());
+  clock.fork = 1;
+  ++clock.stamp;
+  pool[3] = -3;
+  pool.Erase(70);
+  pool[pool.Insert()] = 100;
+  clock.fork = 2;
+  ++clock.stamp;
+  pool.Clear();
+  for (int i = 0; i < 200; ++i) {
+    pool[pool.Insert()] = -i;
+  }
+  pool.Rollback(1);
+  ASSERT_TRUE(std::ranges::equal(pool, forked));
+  // The restored pool takes slots as it did at the fork.
+  ASSERT_EQ(pool.Insert(), 100);
+}
+
+TEST(DataPoolTests, DisabledElementsStayInPlace) {
+  ecsify::internal::DataPool<int> pool{};
+  for (int i = 0; i < 100; ++i) {
+    pool[pool.Insert()] = i;
+  }
+  pool.SetEnabled(5, false);
+  pool.SetEnabled(70, false);
+  ASSERT_FALSE(pool.Enabled(5));
+  ASSERT_EQ(std::ranges::distance(pool), 100);
+  ASSERT_EQ(std::popcount(pool.BucketAt(0).EnabledMask()), 63);
+  // Permuted elements keep their bits.
+  std::vector<std::size_t> order = {70, 5, 6};
+  pool.Permute(order);
+  ASSERT_FALSE(pool.Enabled(0));
+  ASSERT_FALSE(pool.Enabled(1));
+  ASSERT_TRUE(pool.Enabled(2));
+  // Erased slots are reused enabled.
+  pool.Erase(0);
+  ASSERT_TRUE(pool.Enabled(pool.Insert()));
+}
+
+TEST(DataPoolTests, MappedPoolSurvivesReopen) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "ecsify_data_pool_test.pool";
+  std::filesystem::remove(path);
+  std::vector<std::size_t> indices;
+  {
+    ecsify::internal::DataPool<std::size_t> pool{path};
+    for (std::size_t i = 0; i < 200; ++i) {
+      std::size_t idx = pool.Insert();
+      pool[idx] = i;
+      indices.push_back(idx);
+    }
+    pool.Erase(indices[3]);
+    pool.Sync();
+  }
+  {
+    ecsify::internal::DataPool<std::size_t> pool{path};
+    ASSERT_FALSE(pool.Contains(indices[3]));
+    for (std::size_t i = 0; i < 200; ++i) {
+      if (i != 3) {
+        ASSERT_EQ(pool[indices[i]], i);
+      }
+    }
+    ASSERT_EQ(std::ranges::distance(pool), 199);
+    pool.Insert();
+    ASSERT_EQ(std::ranges::distance(pool), 200);
+    pool.Permute(std::vector<std::size_t>{indices[10], indices[5]});
+    ASSERT_EQ(pool[0], 10);
+    ASSERT_EQ(pool[1], 5);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(DataPoolTests, VersionsFollowWrites) {
+  constexpr std::size_t kCapacity = ecsify::internal::Bucket<int>::Capacity();
+  std::uint64_t tick = 1;
+  ecsify::internal::DataPool<int> pool{};
+  pool.TrackWrites(&tick);
+  pool.Fill(0, 2 * kCapacity);
+  tick = 2;
+  ASSERT_EQ(std::as_const(pool)[kCapacity], 0);
+  ASSERT_EQ(pool.Version(1), 1);
+  pool[kCapacity] = 3;
+  ASSERT_EQ(pool.Version(0), 1);
+  ASSERT_EQ(pool.Version(1), 2);
+  tick = 3;
+  pool.SetEnabled(0, false);
+  pool.Erase(kCapacity + 1);
+  ASSERT_EQ(pool.Version(0), 3);
+  ASSERT_EQ(pool.Version(1), 3);
+}
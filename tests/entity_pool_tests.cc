@@ -1,10 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
 #include "ecsify/entity.h"
 #include "ecsify/internal/entity_pool.h"
 
 TEST(EntityPoolTests, Add) {
-  ecsify::internal::EntityPool<0> pool;
+  ecsify::internal::EntityPool pool;
   ecsify::Entity entity1 = pool.Add();
   ASSERT_TRUE(pool.Alive(entity1));
   ecsify::Entity entity2 = pool.Add();
@@ -13,7 +19,7 @@ TEST(EntityPoolTests, Add) {
 }
 
 TEST(EntityPoolTests, Remove) {
-  ecsify::internal::EntityPool<0> pool;
+  ecsify::internal::EntityPool pool;
   ecsify::Entity entity1 = pool.Add();
   ecsify::Entity entity2 = pool.Add();
   pool.Remove(entity1);
@@ -22,3 +28,111 @@ TEST(EntityPoolTests, Remove) {
   pool.Remove(entity2);
   ASSERT_FALSE(pool.Alive(entity2));
 }
+
+TEST(EntityPoolTests, ReuseHandles) {
+  ecsify::internal::EntityPool pool;
+  ecsify::Entity entity1 = pool.Add();
+  pool.Remove(entity1);
+  ecsify::Entity entity2 = pool.Add();
+  ASSERT_EQ(entity1.handle(), entity2.handle());
+  ASSERT_NE(entity1.id(), entity2.id());
+  ASSERT_FALSE(pool.Alive(entity1));
+  ASSERT_TRUE(pool.Alive(entity2));
+}
+
+TEST(EntityPoolTests, ReserveConcurrently) {
+  constexpr std::size_t kNumThreads = 4;
+  constexpr std::size_t kPerThread = 1000;
+  ecsify::internal::EntityPool pool;
+  ecsify::Entity removed = pool.Add();
+  pool.Remove(removed);
+  std::vector<std::vector<ecsify::Entity>> reserved(kNumThreads);
+  std::vector<std::thread> threads;
+  for (std::size_t idx = 0; idx < kNumThreads; ++idx) {
+    threads.emplace_back([&pool, &reserved, idx] {
+      for (std::size_t jdx = 0; jdx < kPerThread / 2; ++jdx) {
+        reserved[idx].push_back(pool.Reserve());
+      }
+      std::vector<ecsify::Entity> batch = pool.Reserve(kPerThread / 2);
+      reserved[idx].insert(reserved[idx].end(), batch.begin(), batch.end());
+    });
+  }
+  ecsify::Entity added = pool.Add();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::set<std::size_t> handles;
+  for (const std::vector<ecsify::Entity> &entities : reserved) {
+    for (ecsify::Entity entity : entities) {
+      ASSERT_FALSE(pool.Alive(entity));
+      handles.insert(entity.handle());
+    }
+  }
+  ASSERT_EQ(handles.size(), kNumThreads * kPerThread);
+  ASSERT_FALSE(handles.contains(added.handle()));
+  std::size_t flushed = 0;
+  pool.Flush([&flushed](ecsify::Entity) { ++flushed; });
+  ASSERT_EQ(flushed, kNumThreads * kPerThread);
+  for (const std::vector<ecsify::Entity> &entities : reserved) {
+    for (ecsify::Entity entity : entities) {
+      ASSERT_TRUE(pool.Alive(entity));
+    }
+  }
+  ASSERT_TRUE(pool.Alive(added));
+}
+
+TEST(EntityPoolTests, ReserveReusesFlushedHandles) {
+  ecsify::internal::EntityPool pool;
+  std::set<std::int64_t> ids;
+  for (int round = 0; round < 100; ++round) {
+    std::vector<ecsify::Entity> reserved = pool.Reserve(10);
+    reserved.push_back(pool.Reserve());
+    pool.Flush([](ecsify::Entity) {});
+    for (ecsify::Entity entity : reserved) {
+      ASSERT_TRUE(pool.Alive(entity));
+      ASSERT_TRUE(ids.insert(entity.id()).second);
+      pool.Remove(entity);
+    }
+  }
+  // Handles freed by a round are recycled by the Flush of the next one.
+  ASSERT_LE(pool.Capacity(), 22);
+}
+
+TEST(EntityPoolTests, ReserveRecycledConcurrentlyWithFlush) {
+  constexpr std::size_t kNumThreads = 4;
+  constexpr std::size_t kPerThread = 2000;
+  ecsify::internal::EntityPool pool;
+  for (std::size_t idx = 0; idx < kNumThreads * kPerThread; ++idx) {
+    pool.Remove(pool.Add());
+  }
+  pool.Flush([](ecsify::Entity) {});
+  std::vector<std::vector<ecsify::Entity>> reserved(kNumThreads);
+  std::vector<std::thread> threads;
+  for (std::size_t idx = 0; idx < kNumThreads; ++idx) {
+    threads.emplace_back([&pool, &reserved, idx] {
+      for (std::size_t jdx = 0; jdx < kPerThread; jdx += 4) {
+        reserved[idx].push_back(pool.Reserve());
+        std::vector<ecsify::Entity> batch = pool.Reserve(3);
+        reserved[idx].insert(reserved[idx].end(), batch.begin(), batch.end());
+      }
+    });
+  }
+  std::size_t flushed = 0;
+  for (int flush = 0; flush < 100; ++flush) {
+    pool.Flush([&flushed](ecsify::Entity) { ++flushed; });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  pool.Flush([&flushed](ecsify::Entity) { ++flushed; });
+  std::set<std::size_t> handles;
+  for (const std::vector<ecsify::Entity> &entities : reserved) {
+    for (ecsify::Entity entity : entities) {
+      ASSERT_TRUE(pool.Alive(entity));
+      handles.insert(entity.handle());
+    }
+  }
+  ASSERT_EQ(handles.size(), kNumThreads * kPerThread);
+  ASSERT_EQ(flushed, kNumThreads * kPerThread);
+  ASSERT_EQ(pool.Capacity(), kNumThreads * kPerThread);
+}
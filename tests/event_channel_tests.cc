@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "ecsify/event_channel.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Damage {
+  int amount;
+};
+
+struct Spawn {
+  int kind;
+};
+
+}  // namespace
+
+TEST(EventChannelTests, ReadsEventsOfPreviousSwap) {
+  ecsify::EventChannel<Damage> channel;
+  channel.Write(Damage{.amount = 1});
+  channel.Write(Damage{.amount = 2});
+  ASSERT_TRUE(channel.Read().empty());
+  channel.Swap();
+  ASSERT_EQ(channel.Read().size(), 2);
+  ASSERT_EQ(channel.Read()[0].amount, 1);
+  ASSERT_EQ(channel.Read()[1].amount, 2);
+  channel.Write(Damage{.amount = 3});
+  ASSERT_EQ(channel.Read().size(), 2);
+  channel.Swap();
+  ASSERT_EQ(channel.Read().size(), 1);
+  ASSERT_EQ(channel.Read()[0].amount, 3);
+  channel.Swap();
+  ASSERT_TRUE(channel.Read().empty());
+}
+
+TEST(EventChannelTests, ReusesMemory) {
+  ecsify::EventChannel<Damage> channel;
+  for (int i = 0; i < 100; ++i) {
+    channel.Write(Damage{.amount = i});
+  }
+  channel.Swap();
+  const Damage *data = channel.Read().data();
+  for (int i = 0; i < 100; ++i) {
+    channel.Write(Damage{.amount = i});
+  }
+  channel.Swap();
+  ASSERT_EQ(channel.Read().data(), data);
+  ASSERT_EQ(channel.Read().size(), 100);
+}
+
+TEST(EventChannelTests, ConcurrentWriters) {
+  constexpr int kNumThreads = 8;
+  constexpr int kPerThread = 1000;
+  ecsify::EventChannel<Damage> channel;
+  std::vector<std::thread> threads;
+  for (int idx = 0; idx < kNumThreads; ++idx) {
+    threads.emplace_back([&channel, idx] {
+      for (int jdx = 0; jdx < kPerThread; ++jdx) {
+        channel.Write(Damage{.amount = idx * kPerThread + jdx});
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  channel.Swap();
+  std::vector<int> amounts;
+  for (const Damage &damage : channel.Read()) {
+    amounts.push_back(damage.amount);
+  }
+  std::ranges::sort(amounts);
+  ASSERT_EQ(amounts.size(), kNumThreads * kPerThread);
+  for (std::size_t idx = 0; idx < amounts.size(); ++idx) {
+    ASSERT_EQ(amounts[idx], static_cast<int>(idx));
+  }
+}
+
+TEST(EventChannelTests, SystemsTalkThroughWorld) {
+  std::vector<int> received;
+  auto world = ecsify::WorldBuilder{}
+                   .Event<Damage>()
+                   .Event<Spawn>()
+                   .System([](ecsify::World &world) {
+                     world.Events<Damage>().Write(Damage{.amount = 5});
+                   })
+                   .System([&received](ecsify::World &world) {
+                     for (const Damage &damage :
+                          world.Events<Damage>().Read()) {
+                       received.push_back(damage.amount);
+                     }
+                   })
+                   .Build();
+  world->Update();
+  ASSERT_TRUE(received.empty());
+  world->Update();
+  ASSERT_EQ(received, std::vector<int>{5});
+  world->Update();
+  ASSERT_EQ(received, (std::vector<int>{5, 5}));
+  ASSERT_TRUE(world->Events<Spawn>().Read().empty());
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/hierarchy.h"
+#include "ecsify/internal/fork_clock.h"
+#include "ecsify/internal/hierarchy.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+std::vector<ecsify::Entity> Entities(std::size_t count) {
+  std::vector<ecsify::Entity> entities;
+  for (std::size_t i = 0; i < count; ++i) {
+    entities.emplace_back(static_cast<std::int64_t>(i), i);
+  }
+  return entities;
+}
+
+}  // namespace
+
+TEST(HierarchyTests, LinkUnlink) {
+  ecsify::internal::Hierarchy hierarchy;
+  std::vector<ecsify::Entity> entts = Entities(3);
+  hierarchy.Link(entts[1], entts[0]);
+  hierarchy.Link(entts[2], entts[0]);
+  ASSERT_EQ(hierarchy.Parent(entts[1]), entts[0]);
+  ASSERT_EQ(hierarchy.Parent(entts[2]), entts[0]);
+  ASSERT_EQ(hierarchy.Parent(entts[0]), ecsify::Entity{});
+  ASSERT_TRUE(std::ranges::equal(hierarchy.Children(entts[0]),
+                                 std::vector{entts[1], entts[2]}));
+  hierarchy.Unlink(entts[1]);
+  ASSERT_EQ(hierarchy.Parent(entts[1]), ecsify::Entity{});
+  ASSERT_TRUE(std::ranges::equal(hierarchy.Children(entts[0]),
+                                 std::vector{entts[2]}));
+  // Relinking replaces the previous parent.
+  hierarchy.Link(entts[2], entts[1]);
+  ASSERT_TRUE(hierarchy.Children(entts[0]).empty());
+  ASSERT_EQ(hierarchy.Parent(entts[2]), entts[1]);
+}
+
+TEST(HierarchyTests, ParentsPrecedeChildren) {
+  ecsify::internal::Hierarchy hierarchy;
+  std::vector<ecsify::Entity> entts = Entities(7);
+  hierarchy.Link(entts[3], entts[6]);
+  hierarchy.Link(entts[5], entts[3]);
+  hierarchy.Link(entts[0], entts[5]);
+  hierarchy.Link(entts[4], entts[6]);
+  hierarchy.Link(entts[2], entts[1]);
+
+  std::span<const ecsify::HierarchyNode> order = hierarchy.Traverse();
+  ASSERT_EQ(order.size(), entts.size());
+  std::vector<std::size_t> depth(order.size());
+  for (std::size_t idx = 0; idx < order.size(); ++idx) {
+    const ecsify::HierarchyNode &node = order[idx];
+    if (node.parent == ecsify::HierarchyNode::kNoParent) {
+      ASSERT_EQ(hierarchy.Parent(node.entity), ecsify::Entity{});
+      continue;
+    }
+    ASSERT_LT(node.parent, idx);
+    ASSERT_EQ(order[node.parent].entity, hierarchy.Parent(node.entity));
+    depth[idx] = depth[node.parent] + 1;
+    ASSERT_GE(depth[idx], depth[idx - 1]);
+  }
+}
+
+TEST(HierarchyTests, ErasedEntitiesAreDetached) {
+  ecsify::internal::Hierarchy hierarchy;
+  std::vector<ecsify::Entity> entts = Entities(4);
+  hierarchy.Link(entts[1], entts[0]);
+  hierarchy.Link(entts[2], entts[1]);
+  hierarchy.Link(entts[3], entts[1]);
+  ASSERT_EQ(hierarchy.Traverse().size(), 4);
+  hierarchy.Erase(entts[1]);
+  ASSERT_TRUE(hierarchy.Children(entts[0]).empty());
+  ASSERT_EQ(hierarchy.Parent(entts[2]), ecsify::Entity{});
+  ASSERT_EQ(hierarchy.Parent(entts[3]), ecsify::Entity{});
+  ASSERT_TRUE(hierarchy.Traverse().empty());
+}
+
+TEST(HierarchyTests, StaleEntitiesAreUnlinked) {
+  ecsify::internal::Hierarchy hierarchy;
+  std::vector<ecsify::Entity> entts = Entities(2);
+  hierarchy.Link(entts[1], entts[0]);
+  // Entities reusing the handles of linked ones.
+  ecsify::Entity stale_child{7, entts[1].handle()};
+  ecsify::Entity stale_parent{8, entts[0].handle()};
+  ASSERT_EQ(hierarchy.Parent(stale_child), ecsify::Entity{});
+  ASSERT_TRUE(hierarchy.Children(stale_parent).empty());
+  hierarchy.Unlink(stale_child);
+  hierarchy.Erase(stale_parent);
+  ASSERT_EQ(hierarchy.Parent(entts[1]), entts[0]);
+}
+
+TEST(HierarchyTests, RollbackRestoresJournaledBlocks) {
+  ecsify::internal::ForkClock clock{.depth = 2};
+  ecsify::internal::Hierarchy hierarchy;
+  hierarchy.Journal(&clock);
+  std::vector<ecsify::Entity> entts = Entities(200);
+  hierarchy.Link(entts[1], entts[0]);
+  hierarchy.Link(entts[150], entts[0]);
+  std::uint64_t fork = ++clock.fork;
+  ++clock.stamp;
+  hierarchy.Erase(entts[0]);
+  hierarchy.Link(entts[150], entts[100]);
+  hierarchy.Link(entts[199], entts[100]);
+  ASSERT_EQ(hierarchy.Parent(entts[150]), entts[100]);
+
+  hierarchy.Rollback(fork);
+  ++clock.stamp;
+  ASSERT_EQ(hierarchy.Parent(entts[1]), entts[0]);
+  ASSERT_EQ(hierarchy.Parent(entts[150]), entts[0]);
+  ASSERT_EQ(hierarchy.Parent(entts[199]), ecsify::Entity{});
+  ASSERT_TRUE(hierarchy.Children(entts[100]).empty());
+  ASSERT_EQ(hierarchy.Children(entts[0]).size(), 2);
+  ASSERT_EQ(hierarchy.Traverse().size(), 3);
+}
+
+struct Depth : ecsify::ComponentMixin<1> {
+  int val;
+};
+
+TEST(HierarchyTests, WorldPropagation) {
+  auto world = ecsify::WorldBuilder{}.Component<Depth>().Build();
+  ecsify::Entity root = world->Add();
+  ecsify::Entity child = world->Add();
+  ecsify::Entity grandchild = world->Add();
+  world->SetParent(grandchild, child);
+  world->SetParent(child, root);
+
+  std::span<const ecsify::HierarchyNode> order = world->Hierarchy();
+  std::vector<int> depth(order.size());
+  for (std::size_t idx = 0; idx < order.size(); ++idx) {
+    if (order[idx].parent != ecsify::HierarchyNode::kNoParent) {
+      depth[idx] = depth[order[idx].parent] + 1;
+    }
+    world->Add<Depth>(order[idx].entity);
+    world->Get<Depth>(order[idx].entity).val = depth[idx];
+  }
+  ASSERT_EQ(world->Get<Depth>(root).val, 0);
+  ASSERT_EQ(world->Get<Depth>(child).val, 1);
+  ASSERT_EQ(world->Get<Depth>(grandchild).val, 2);
+
+  world->Remove(child);
+  ASSERT_TRUE(world->Children(root).empty());
+  ASSERT_EQ(world->Parent(grandchild), ecsify::Entity{});
+  ASSERT_TRUE(world->Hierarchy().empty());
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <future>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/region.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Position : ecsify::ComponentMixin<1> {
+  float x, y;
+};
+
+struct Health : ecsify::ComponentMixin<2> {
+  int value;
+};
+
+struct Name : ecsify::ComponentMixin<3> {
+  std::string value;
+};
+
+std::filesystem::path RegionPath() {
+  return std::filesystem::temp_directory_path() / "ecsify_region_test.bin";
+}
+
+auto BuildWorld() {
+  return ecsify::WorldBuilder{}
+      .Component<Position>()
+      .Component<Health>()
+      .Component<Name>()
+      .Build();
+}
+
+}  // namespace
+
+TEST(RegionTests, SaveUnloadAndLoad) {
+  auto world = BuildWorld();
+  ecsify::Entity outside = world->Add();
+  world->Add<Health>(outside);
+  ecsify::Region region = world->AddRegion();
+  for (int i = 0; i < 100; ++i) {
+    ecsify::Entity entity = world->Add(region);
+    world->Add<Health>(entity);
+    world->Get<Health>(entity).value = i;
+    if (i % 2 == 0) {
+      world->Add<Position>(entity);
+      world->Get<Position>(entity) =
+          Position{.x = static_cast<float>(i), .y = 1};
+    }
+  }
+  ASSERT_EQ(std::ranges::distance(world->Query<Health>()), 101);
+  world->SaveRegion(region, RegionPath());
+  world->UnloadRegion(region);
+  ASSERT_EQ(std::ranges::distance(world->Query<Health>()), 1);
+  ASSERT_TRUE(world->Alive(outside));
+
+  // The chunk is read on another thread and only spliced on this one.
+  auto prepared = std::async(std::launch::async, [&world]() {
+    return world->PrepareRegion(RegionPath());
+  });
+  ecsify::RegionChunk chunk = prepared.get();
+  ASSERT_EQ(chunk.size(), 100);
+  ecsify::Region loaded = world->LoadRegion(std::move(chunk));
+  ASSERT_EQ(std::ranges::distance(world->Query<Health>()), 101);
+  ASSERT_EQ(std::ranges::distance(world->Query<Position, Health>()), 50);
+  int sum = 0;
+  for (auto [entity, health] : world->Query<ecsify::Entity, Health>()) {
+    ASSERT_TRUE(world->Alive(entity));
+    ASSERT_EQ(world->Get<Health>(entity).value, health.value);
+    sum += health.value;
+  }
+  ASSERT_EQ(sum, 99 * 100 / 2);
+  for (auto [position, health] : world->Query<Position, Health>()) {
+    ASSERT_EQ(static_cast<int>(position.x), health.value);
+  }
+
+  // Components added to loaded entities stay in the region.
+  for (auto [entity, position] : world->Query<ecsify::Entity, Position>()) {
+    world->Remove<Position>(entity);
+    break;
+  }
+  world->UnloadRegion(loaded);
+  ASSERT_EQ(std::ranges::distance(world->Query<Health>()), 1);
+  ASSERT_EQ(std::ranges::distance(world->Query<Position>()), 0);
+  std::filesystem::remove(RegionPath());
+}
+
+TEST(RegionTests, RejectsUnsavableComponents) {
+  auto world = BuildWorld();
+  ecsify::Region region = world->AddRegion();
+  ecsify::Entity entity = world->Add(region);
+  world->Add<Name>(entity);
+  ASSERT_THROW(world->SaveRegion(region, RegionPath()), std::runtime_error);
+  ASSERT_THROW(world->PrepareRegion(RegionPath().string() + ".missing"),
+               std::runtime_error);
+  std::filesystem::remove(RegionPath());
+}
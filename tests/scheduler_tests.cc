@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ecsify/schedule.h"
+#include "ecsify/task.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+using std::chrono::milliseconds;
+
+}  // namespace
+
+TEST(SchedulerTests, PhasesRunInOrder) {
+  std::string trace;
+  auto world =
+      ecsify::WorldBuilder{}
+          .System([&](ecsify::World & /*world*/) { trace += "u"; })
+          .System([&](ecsify::World & /*world*/) { trace += "post"; },
+                  ecsify::Phase::kPostUpdate)
+          .System([&](ecsify::World & /*world*/) { trace += "pre"; },
+                  ecsify::Phase::kPreUpdate)
+          .System([&](ecsify::World & /*world*/) { trace += "U"; })
+          .Build();
+  world->Update();
+  ASSERT_EQ(trace, "preuUpost");
+}
+
+TEST(SchedulerTests, FixedStepCatchesUp) {
+  std::vector<ecsify::Duration> steps;
+  auto world = ecsify::WorldBuilder{}
+                   .Group("physics",
+                          ecsify::FixedStep{.step = milliseconds{10},
+                                            .max_steps = 4})
+                   .System(
+                       [&](ecsify::World &world) {
+                         steps.push_back(world.DeltaTime());
+                       },
+                       "physics")
+                   .Build();
+  world->Update(milliseconds{5});
+  ASSERT_EQ(steps.size(), 0);
+  world->Update(milliseconds{5});
+  ASSERT_EQ(steps.size(), 1);
+  world->Update(milliseconds{25});
+  ASSERT_EQ(steps.size(), 3);
+  // Falling too far behind drops the steps above the limit.
+  world->Update(milliseconds{1005});
+  ASSERT_EQ(steps.size(), 7);
+  world->Update(milliseconds{10});
+  ASSERT_EQ(steps.size(), 8);
+  for (ecsify::Duration step : steps) {
+    ASSERT_EQ(step, milliseconds{10});
+  }
+}
+
+TEST(SchedulerTests, TickDivisor) {
+  std::vector<ecsify::Duration> runs;
+  int ticks = 0;
+  auto world = ecsify::WorldBuilder{}
+                   .Group("ai", ecsify::TickDivisor{3})
+                   .System(
+                       [&](ecsify::World &world) {
+                         runs.push_back(world.DeltaTime());
+                       },
+                       "ai")
+                   .System([&](ecsify::World & /*world*/) { ++ticks; })
+                   .Build();
+  for (int i = 0; i < 7; ++i) {
+    world->Update(milliseconds{1});
+  }
+  ASSERT_EQ(ticks, 7);
+  ASSERT_EQ(runs, (std::vector<ecsify::Duration>{
+                      milliseconds{1}, milliseconds{3}, milliseconds{3}}));
+}
+
+TEST(SchedulerTests, RejectsZeroRates) {
+  ecsify::WorldBuilder builder;
+  EXPECT_DEBUG_DEATH(
+      builder.Group("physics", ecsify::FixedStep{.step = milliseconds{0}}),
+      "Fixed step must be positive");
+  EXPECT_DEBUG_DEATH(builder.Group("ai", ecsify::TickDivisor{0}),
+                     "Tick divisor must be positive");
+}
+
+TEST(SchedulerTests, CoroutinesWaitForPhases) {
+  std::string trace;
+  auto world =
+      ecsify::WorldBuilder{}
+          .System([&](ecsify::World & /*world*/) -> ecsify::Task {
+            while (true) {
+              trace += "a";
+              co_await ecsify::WaitPhase{ecsify::Phase::kPostUpdate};
+              trace += "b";
+              co_await ecsify::WaitPhase{ecsify::Phase::kPreUpdate};
+              trace += "c";
+              co_await ecsify::NextTick{};
+            }
+          })
+          .System([&](ecsify::World & /*world*/) { trace += "|"; },
+                  ecsify::Phase::kPostUpdate)
+          .Build();
+  world->Update();
+  world->Update();
+  world->Update();
+  ASSERT_EQ(trace, "ab|c|ab|");
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/internal/numa.h"
+#include "ecsify/sharded_world.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Counter : ecsify::ComponentMixin<1> {
+  int val;
+};
+
+struct Tag : ecsify::ComponentMixin<2> {};
+
+void CountSystem(ecsify::World &world) {
+  for (auto [counter] : world.Query<Counter>()) {
+    ++counter.val;
+  }
+}
+
+}  // namespace
+
+TEST(ShardedWorldTests, MigrationKeepsComponents) {
+  auto shards = ecsify::WorldBuilder{}
+                    .Component<Counter>()
+                    .Component<Tag>()
+                    .BuildShards(2);
+  ecsify::World &from = (*shards)[0];
+  ecsify::World &to = (*shards)[1];
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 100; ++i) {
+    ecsify::Entity entity = from.Add();
+    from.Add<Counter>(entity);
+    from.Get<Counter>(entity).val = i;
+    if (i % 2 == 0) {
+      from.Add<Tag>(entity);
+    }
+    entities.push_back(entity);
+  }
+  std::vector<ecsify::Entity> migrated =
+      shards->Migrate(std::span{entities}.subspan(50), 0, 1);
+  ASSERT_EQ(migrated.size(), 50);
+  for (std::size_t idx = 0; idx < migrated.size(); ++idx) {
+    ASSERT_FALSE(from.Alive(entities[50 + idx]));
+    ASSERT_TRUE(to.Alive(migrated[idx]));
+    ASSERT_EQ(to.Get<Counter>(migrated[idx]).val, 50 + idx);
+    ASSERT_EQ(to.Has<Tag>(migrated[idx]), idx % 2 == 0);
+  }
+  for (auto [entity, counter] : to.Query<ecsify::Entity, Counter>()) {
+    ASSERT_EQ(to.Get<Counter>(entity).val, counter.val);
+  }
+  ASSERT_EQ(std::ranges::distance(from.Query<ecsify::Entity>()), 50);
+  ASSERT_EQ(std::ranges::distance(to.Query<ecsify::Entity, Tag>()), 25);
+}
+
+TEST(ShardedWorldTests, MigrationFillsFreedRows) {
+  auto shards = ecsify::WorldBuilder{}
+                    .Component<Counter>()
+                    .Component<Tag>()
+                    .BuildShards(2);
+  ecsify::World &from = (*shards)[0];
+  ecsify::World &to = (*shards)[1];
+  std::vector<ecsify::Entity> kept;
+  for (int i = 0; i < 100; ++i) {
+    ecsify::Entity entity = to.Add();
+    to.Add<Counter>(entity);
+    to.Add<Tag>(entity);
+    to.Get<Counter>(entity).val = -1;
+    if (i % 3 == 0) {
+      to.Remove(entity);
+    } else {
+      kept.push_back(entity);
+    }
+  }
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 100; ++i) {
+    ecsify::Entity entity = from.Add();
+    from.Add<Counter>(entity);
+    from.Add<Tag>(entity);
+    from.Get<Counter>(entity).val = i;
+    if (i % 4 == 0) {
+      from.Disable<Counter>(entity);
+    }
+    entities.push_back(entity);
+  }
+  std::vector<ecsify::Entity> migrated = shards->Migrate(entities, 0, 1);
+  for (std::size_t idx = 0; idx < migrated.size(); ++idx) {
+    ASSERT_EQ(to.Get<Counter>(migrated[idx]).val, idx);
+    ASSERT_EQ(to.Enabled<Counter>(migrated[idx]), idx % 4 != 0);
+  }
+  for (ecsify::Entity entity : kept) {
+    ASSERT_EQ(to.Get<Counter>(entity).val, -1);
+  }
+  for (auto [entity, counter] : to.Query<ecsify::Entity, Counter>()) {
+    ASSERT_EQ(to.Get<Counter>(entity).val, counter.val);
+  }
+  ASSERT_EQ(std::ranges::distance(to.Query<ecsify::Entity, Tag>()),
+            kept.size() + migrated.size());
+}
+
+TEST(ShardedWorldTests, ShardsUpdateInParallel) {
+  constexpr std::size_t kShards = 4;
+  auto shards = ecsify::WorldBuilder{}
+                    .Component<Counter>()
+                    .System(CountSystem)
+                    .BuildShards(kShards);
+  for (std::size_t idx = 0; idx < kShards; ++idx) {
+    for (std::size_t i = 0; i <= idx; ++i) {
+      ecsify::Entity entity = (*shards)[idx].Add();
+      (*shards)[idx].Add<Counter>(entity);
+    }
+  }
+  constexpr int kTicks = 10;
+  for (int tick = 0; tick < kTicks; ++tick) {
+    shards->Update();
+  }
+  for (std::size_t idx = 0; idx < kShards; ++idx) {
+    std::size_t num_counters = 0;
+    for (auto [counter] : (*shards)[idx].Query<Counter>()) {
+      ASSERT_EQ(counter.val, kTicks);
+      ++num_counters;
+    }
+    ASSERT_EQ(num_counters, idx + 1);
+  }
+}
+
+TEST(ShardedWorldTests, NumaPlacedShards) {
+  ASSERT_EQ(ecsify::internal::ParseCpuList("0-2,5,7-8"),
+            (std::vector<int>{0, 1, 2, 5, 7, 8}));
+  auto shards = ecsify::WorldBuilder{}
+                    .Component<Counter>()
+                    .System(CountSystem)
+                    .BuildShards(2, ecsify::Placement::kNuma);
+  std::vector<ecsify::internal::NumaNode> nodes = ecsify::internal::NumaNodes();
+  ASSERT_FALSE(nodes.empty());
+  for (std::size_t idx = 0; idx < shards->Size(); ++idx) {
+    ASSERT_EQ(shards->Node(idx), nodes[idx % nodes.size()].id);
+  }
+  shards->Run([](ecsify::World &world) {
+    for (int i = 0; i < 100; ++i) {
+      world.Add<Counter>(world.Add());
+    }
+  });
+  std::vector<ecsify::Entity> entities;
+  for (auto [entity] : (*shards)[0].Query<ecsify::Entity>()) {
+    entities.push_back(entity);
+  }
+  std::vector<ecsify::Entity> migrated = shards->Migrate(entities, 0, 1);
+  ASSERT_EQ(migrated.size(), 100);
+  shards->Update();
+  ASSERT_EQ(std::ranges::distance((*shards)[0].Query<Counter>()), 0);
+  for (auto [counter] : (*shards)[1].Query<Counter>()) {
+    ASSERT_EQ(counter.val, 1);
+  }
+  ASSERT_EQ(std::ranges::distance((*shards)[1].Query<Counter>()), 200);
+}
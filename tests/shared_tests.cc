@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <ranges>
+#include <set>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/region.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Position : ecsify::ComponentMixin<1> {
+  float x, y;
+};
+
+struct Material : ecsify::ComponentMixin<2> {
+  int shader;
+  int texture;
+
+  friend bool operator==(const Material &lhs, const Material &rhs) {
+    return lhs.shader == rhs.shader && lhs.texture == rhs.texture;
+  }
+};
+
+auto BuildWorld() {
+  return ecsify::WorldBuilder{}
+      .Component<Position>()
+      .Component<Material>()
+      .Shared<Material>()
+      .Build();
+}
+
+}  // namespace
+
+TEST(SharedTests, GroupsByValue) {
+  auto world = BuildWorld();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 30; ++i) {
+    ecsify::Entity entity = world->Add();
+    world->Add<Position>(entity);
+    world->Get<Position>(entity).x = static_cast<float>(i);
+    world->SetShared(entity, Material{.shader = i % 3, .texture = 7});
+    entities.push_back(entity);
+  }
+  // Equal values are stored once.
+  ASSERT_EQ(&world->GetShared<Material>(entities[0]),
+            &world->GetShared<Material>(entities[3]));
+  ASSERT_NE(&world->GetShared<Material>(entities[0]),
+            &world->GetShared<Material>(entities[1]));
+  ASSERT_EQ(world->GetShared<Material>(entities[4]).shader, 1);
+
+  auto groups = world->QueryShared<Material, ecsify::Entity, Position>();
+  ASSERT_EQ(groups.size(), 3);
+  std::set<int> shaders;
+  for (auto [material, rows] : groups) {
+    shaders.insert(material.shader);
+    ASSERT_EQ(std::ranges::distance(rows), 10);
+    for (auto [entity, position] : rows) {
+      ASSERT_EQ(static_cast<int>(position.x) % 3, material.shader);
+      ASSERT_EQ(&world->GetShared<Material>(entity), &material);
+    }
+  }
+  ASSERT_EQ(shaders, (std::set<int>{0, 1, 2}));
+  ASSERT_EQ(std::ranges::distance(world->Query<Position>()), 30);
+
+  // Changing the value moves the entity to another group.
+  world->SetShared(entities[0], Material{.shader = 1, .texture = 7});
+  world->Remove<Material>(entities[1]);
+  ASSERT_FALSE(world->Has<Material>(entities[1]));
+  ASSERT_EQ(world->Get<Position>(entities[0]).x, 0);
+  for (auto [material, rows] :
+       world->QueryShared<Material, ecsify::Entity, Position>()) {
+    ASSERT_EQ(std::ranges::distance(rows), material.shader == 0 ? 9 : 10);
+  }
+
+  // Added shared components take the default value.
+  world->Add<Material>(entities[1]);
+  ASSERT_EQ(world->GetShared<Material>(entities[1]), Material{});
+  auto regrouped = world->QueryShared<Material, Position>();
+  ASSERT_EQ(regrouped.size(), 4);
+}
+
+TEST(SharedTests, PrefabsAndRegionsKeepValues) {
+  auto world = BuildWorld();
+  ecsify::Entity prefab = world->AddPrefab();
+  world->Add<Position>(prefab);
+  world->SetShared(prefab, Material{.shader = 5, .texture = 6});
+  std::vector<ecsify::Entity> instances = world->Instantiate(prefab, 4);
+  ASSERT_EQ(world->GetShared<Material>(instances[2]).texture, 6);
+  ASSERT_EQ(&world->GetShared<Material>(instances[2]),
+            &world->GetShared<Material>(prefab));
+
+  ecsify::Region region = world->AddRegion();
+  for (int i = 0; i < 10; ++i) {
+    ecsify::Entity entity = world->Add(region);
+    world->Add<Position>(entity);
+    world->SetShared(entity, Material{.shader = i % 2, .texture = 1});
+  }
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "ecsify_shared_test.bin";
+  world->SaveRegion(region, path);
+  world->UnloadRegion(region);
+  world->LoadRegion(world->PrepareRegion(path));
+  std::filesystem::remove(path);
+  std::size_t num_rows = 0;
+  for (auto [material, rows] : world->QueryShared<Material, Position>()) {
+    num_rows += std::ranges::distance(rows);
+  }
+  ASSERT_EQ(num_rows, 14);
+  auto groups = world->QueryShared<Material, Position>();
+  ASSERT_EQ(groups.size(), 3);
+}
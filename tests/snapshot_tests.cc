@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/snapshot.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Position : ecsify::ComponentMixin<1> {
+  long x;
+};
+
+struct Health : ecsify::ComponentMixin<2> {
+  int value;
+};
+
+void MoveSystem(ecsify::World &world) {
+  for (auto [position] : world.Query<Position>()) {
+    ++position.x;
+  }
+}
+
+}  // namespace
+
+TEST(SnapshotTests, PublishedOnUpdate) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Component<Health>()
+                   .System(MoveSystem)
+                   .Snapshot<Position>()
+                   .Build();
+  ASSERT_EQ(world->Snapshot<Position>()->size(), 0);
+  ecsify::Entity entt = world->Add();
+  world->Add<Position>(entt);
+  world->Add<Health>(world->Add());
+  auto before = world->Snapshot<Position>();
+  world->Update();
+  auto after = world->Snapshot<Position>();
+  ASSERT_EQ(before->size(), 0);
+  ASSERT_EQ(after->tick(), 1);
+  ASSERT_EQ(after->size(), 1);
+  ASSERT_EQ(after->entities()[0], entt);
+  ASSERT_EQ(after->values()[0].x, 1);
+  world->Get<Position>(entt).x = 10;
+  ASSERT_EQ(after->values()[0].x, 1);
+  world->Update();
+  ASSERT_EQ(world->Snapshot<Position>()->values()[0].x, 11);
+  ASSERT_EQ(after->values()[0].x, 1);
+}
+
+TEST(SnapshotTests, ReadersSeeWholeTicks) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .System(MoveSystem)
+                   .Snapshot<Position>()
+                   .Build();
+  constexpr std::size_t kEntities = 1000;
+  for (std::size_t idx = 0; idx < kEntities; ++idx) {
+    world->Add<Position>(world->Add());
+  }
+  std::atomic<bool> done{false};
+  std::atomic<std::size_t> torn{0};
+  std::thread reader([&] {
+    while (!done) {
+      auto snapshot = world->Snapshot<Position>();
+      for (const Position &position : snapshot->values()) {
+        if (position.x != static_cast<long>(snapshot->tick())) {
+          ++torn;
+        }
+      }
+    }
+  });
+  for (int tick = 0; tick < 200; ++tick) {
+    world->Update();
+  }
+  done = true;
+  reader.join();
+  ASSERT_EQ(torn, 0);
+  ASSERT_EQ(world->Snapshot<Position>()->tick(), 200);
+}
+
+TEST(SnapshotTests, RefilledBuffersMatchTheWorld) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Component<Health>()
+                   .Snapshot<Position>()
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int idx = 0; idx < 300; ++idx) {
+    entities.push_back(world->Add());
+    world->Add<Position>(entities.back());
+    world->Get<Position>(entities.back()).x = idx;
+  }
+  // Readers holding snapshots make the buffers rotate.
+  std::vector<std::shared_ptr<const ecsify::ComponentSnapshot<Position>>>
+      held;
+  for (int tick = 0; tick < 12; ++tick) {
+    switch (tick % 4) {
+      case 0:
+        world->Get<Position>(entities[tick * 7]).x = -tick;
+        break;
+      case 1:
+        world->Remove(entities[tick]);
+        break;
+      case 2:
+        world->Disable<Position>(entities[200 + tick]);
+        break;
+      case 3:
+        world->Add<Health>(entities[100 + tick]);
+        break;
+    }
+    world->Update();
+    if (tick % 3 == 0) {
+      held.push_back(world->Snapshot<Position>());
+    }
+    auto snapshot = world->Snapshot<Position>();
+    std::vector<std::pair<std::int64_t, long>> expected;
+    for (auto [entity, position] :
+         world->Query<const ecsify::Entity, const Position>()) {
+      expected.emplace_back(entity.id(), position.x);
+    }
+    std::vector<std::pair<std::int64_t, long>> actual;
+    for (std::size_t row = 0; row < snapshot->size(); ++row) {
+      actual.emplace_back(snapshot->entities()[row].id(),
+                          snapshot->values()[row].x);
+    }
+    ASSERT_EQ(actual, expected);
+  }
+}
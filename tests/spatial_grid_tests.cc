@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/spatial_grid.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Position : ecsify::ComponentMixin<1> {
+  float x, y;
+};
+
+using Grid = ecsify::SpatialGrid<Position>;
+
+std::vector<ecsify::Entity> Sorted(std::vector<ecsify::Entity> entities) {
+  std::ranges::sort(entities, {}, &ecsify::Entity::id);
+  return entities;
+}
+
+}  // namespace
+
+TEST(SpatialGridTests, TracksWorldChanges) {
+  auto grid = std::make_shared<Grid>(1.0F);
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Track<Position>(grid)
+                   .Build();
+  ecsify::Entity near = world->Add();
+  world->Add<Position>(near);
+  world->Set(near, Position{.x = 0.5F, .y = 0.5F});
+  ecsify::Entity far = world->Add();
+  world->Add<Position>(far);
+  world->Set(far, Position{.x = 10, .y = 10});
+  ASSERT_EQ(grid->Size(), 2);
+
+  std::vector<ecsify::Entity> result;
+  grid->QueryRadius({0, 0}, 1, result);
+  ASSERT_EQ(result, std::vector{near});
+
+  // Moving inside a cell and across cells.
+  world->Get<Position>(far) = Position{.x = 0.25F, .y = -0.25F};
+  world->Modified<Position>(far);
+  world->Set(near, Position{.x = 0.75F, .y = 0.5F});
+  result.clear();
+  grid->QueryRadius({0, 0}, 1, result);
+  ASSERT_EQ(Sorted(result), Sorted({near, far}));
+
+  world->Remove<Position>(near);
+  world->Remove(far);
+  ASSERT_EQ(grid->Size(), 0);
+  result.clear();
+  grid->QueryBox({-100, -100}, {100, 100}, result);
+  ASSERT_TRUE(result.empty());
+}
+
+TEST(SpatialGridTests, MatchesFullScan) {
+  auto grid = std::make_shared<Grid>(4.0F);
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Track<Position>(grid)
+                   .Build();
+  std::mt19937 gen{42};
+  std::uniform_real_distribution<float> coord{-50, 50};
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 1000; ++i) {
+    ecsify::Entity entity = world->Add();
+    world->Add<Position>(entity);
+    world->Set(entity, Position{.x = coord(gen), .y = coord(gen)});
+    entities.push_back(entity);
+  }
+  for (ecsify::Entity entity : entities | std::views::take(500)) {
+    world->Set(entity, Position{.x = coord(gen), .y = coord(gen)});
+  }
+
+  for (int i = 0; i < 20; ++i) {
+    Grid::Point center = {coord(gen), coord(gen)};
+    float radius = 7.5F;
+    std::vector<ecsify::Entity> expected;
+    for (auto [entity, pos] : world->Query<ecsify::Entity, Position>()) {
+      float dx = pos.x - center[0];
+      float dy = pos.y - center[1];
+      if (dx * dx + dy * dy <= radius * radius) {
+        expected.push_back(entity);
+      }
+    }
+    std::vector<ecsify::Entity> result;
+    grid->QueryRadius(center, radius, result);
+    ASSERT_EQ(Sorted(result), Sorted(expected));
+
+    Grid::Point min = {center[0] - radius, center[1] - radius};
+    Grid::Point max = {center[0] + radius, center[1]};
+    expected.clear();
+    for (auto [entity, pos] : world->Query<ecsify::Entity, Position>()) {
+      if (pos.x >= min[0] && pos.x <= max[0] && pos.y >= min[1] &&
+          pos.y <= max[1]) {
+        expected.push_back(entity);
+      }
+    }
+    result.clear();
+    grid->QueryBox(min, max, result);
+    ASSERT_EQ(Sorted(result), Sorted(expected));
+  }
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ecsify/task.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+std::vector<int> trace;
+
+ecsify::Task Staged(ecsify::World & /*world*/) {
+  trace.push_back(1);
+  co_await ecsify::NextTick{};
+  trace.push_back(2);
+  co_await ecsify::SleepTicks{2};
+  trace.push_back(3);
+  co_await ecsify::SleepTicks{0};
+  trace.push_back(4);
+}
+
+}  // namespace
+
+TEST(TaskTests, ResumesAcrossTicks) {
+  trace.clear();
+  auto world = ecsify::WorldBuilder{}.System(Staged).Build();
+  world->Update();
+  ASSERT_EQ(trace, (std::vector{1}));
+  world->Update();
+  ASSERT_EQ(trace, (std::vector{1, 2}));
+  world->Update();
+  ASSERT_EQ(trace, (std::vector{1, 2}));
+  world->Update();
+  ASSERT_EQ(trace, (std::vector{1, 2, 3, 4}));
+  // Finished coroutines are started again.
+  world->Update();
+  ASSERT_EQ(trace, (std::vector{1, 2, 3, 4, 1}));
+}
+
+TEST(TaskTests, TimeBudgetSpreadsWork) {
+  constexpr int kWork = 1000;
+  int done = 0;
+  int ticks = 0;
+  auto world =
+      ecsify::WorldBuilder{}
+          .System([&](ecsify::World & /*world*/) -> ecsify::Task {
+            for (; done < kWork; ++done) {
+              co_await ecsify::TimeBudget{std::chrono::nanoseconds{0}};
+            }
+          })
+          .System([&](ecsify::World & /*world*/) { ++ticks; })
+          .Build();
+  while (done < kWork) {
+    world->Update();
+  }
+  // Zero budget suspends on every iteration.
+  ASSERT_EQ(ticks, kWork + 1);
+
+  done = 0;
+  ticks = 0;
+  auto unlimited =
+      ecsify::WorldBuilder{}
+          .System([&](ecsify::World & /*world*/) -> ecsify::Task {
+            for (; done < kWork; ++done) {
+              co_await ecsify::TimeBudget{std::chrono::hours{1}};
+            }
+            co_await ecsify::NextTick{};
+          })
+          .Build();
+  unlimited->Update();
+  ASSERT_EQ(done, kWork);
+}
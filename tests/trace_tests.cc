@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/trace.h"
+#include "ecsify/world.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct Position : ecsify::ComponentMixin<1> {
+  float x, y;
+};
+
+struct Health : ecsify::ComponentMixin<2> {
+  int value;
+};
+
+std::filesystem::path TracePath() {
+  return std::filesystem::temp_directory_path() / "ecsify_trace_test.bin";
+}
+
+}  // namespace
+
+TEST(TraceTests, ReadsWrittenRecords) {
+  std::array<std::size_t, 2> sizes = {16, 300};
+  {
+    ecsify::TraceWriter writer{TracePath(), sizes};
+    writer.AddEntity(ecsify::Entity{0, 1000});
+    writer.GetComponent(ecsify::Entity{0, 1000}, 1);
+    std::array<std::size_t, 2> query = {0, 1};
+    writer.Query(query);
+  }
+  ecsify::TraceReader reader{TracePath()};
+  ASSERT_EQ(std::vector<std::size_t>(reader.component_sizes().begin(),
+                                     reader.component_sizes().end()),
+            std::vector<std::size_t>(sizes.begin(), sizes.end()));
+  ecsify::TraceRecord record;
+  ASSERT_TRUE(reader.Next(record));
+  ASSERT_EQ(record.op, ecsify::TraceOp::kAddEntity);
+  ASSERT_EQ(record.entity, 1000);
+  ASSERT_TRUE(reader.Next(record));
+  ASSERT_EQ(record.op, ecsify::TraceOp::kGetComponent);
+  ASSERT_EQ(record.entity, 1000);
+  ASSERT_EQ(record.component, 1);
+  ASSERT_TRUE(reader.Next(record));
+  ASSERT_EQ(record.op, ecsify::TraceOp::kQuery);
+  ASSERT_EQ(record.components, (std::vector<std::size_t>{0, 1}));
+  ASSERT_FALSE(reader.Next(record));
+  std::filesystem::remove(TracePath());
+}
+
+TEST(TraceTests, RejectsUnknownComponentTypes) {
+  std::array<std::size_t, 2> sizes = {16, 4};
+  {
+    ecsify::TraceWriter writer{TracePath(), sizes};
+    writer.GetComponent(ecsify::Entity{0, 3}, 1);
+    writer.GetComponent(ecsify::Entity{0, 3}, 2);
+    std::array<std::size_t, 2> query = {0, 7};
+    writer.Query(query);
+  }
+  ecsify::TraceReader reader{TracePath()};
+  ecsify::TraceRecord record;
+  ASSERT_TRUE(reader.Next(record));
+  ASSERT_THROW(reader.Next(record), std::runtime_error);
+  ASSERT_THROW(reader.Next(record), std::runtime_error);
+  std::filesystem::remove(TracePath());
+}
+
+TEST(TraceTests, RecordsWorldCalls) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Component<Health>()
+                   .RecordTrace(TracePath())
+                   .Build();
+  ecsify::Entity entt = world->Add();
+  world->Add<Health>(entt);
+  world->Set(entt, Health{.value = 3});
+  for (auto [health, entity] : world->Query<Health, ecsify::Entity>()) {
+    ASSERT_EQ(health.value, 3);
+  }
+  world->Remove<Health>(entt);
+  world->Remove(entt);
+  world.reset();
+
+  ecsify::TraceReader reader{TracePath()};
+  ASSERT_EQ(reader.component_sizes().size(), 3);
+  ASSERT_EQ(reader.component_sizes()[2], sizeof(Health));
+  std::vector<ecsify::TraceOp> ops;
+  ecsify::TraceRecord record;
+  while (reader.Next(record)) {
+    ASSERT_EQ(record.entity, entt.handle());
+    ops.push_back(record.op);
+  }
+  ASSERT_EQ(ops, (std::vector<ecsify::TraceOp>{
+                     ecsify::TraceOp::kAddEntity,
+                     ecsify::TraceOp::kAddComponent,
+                     ecsify::TraceOp::kGetComponent,
+                     ecsify::TraceOp::kQuery,
+                     ecsify::TraceOp::kRemoveComponent,
+                     ecsify::TraceOp::kRemoveEntity,
+                 }));
+  std::filesystem::remove(TracePath());
+}
+
+TEST(TraceTests, SnapshotsAreNotRecorded) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Snapshot<Position>()
+                   .RecordTrace(TracePath())
+                   .Build();
+  world->Add<Position>(world->Add());
+  world->Update();
+  world->Update();
+  ASSERT_EQ(world->Snapshot<Position>()->size(), 1);
+  world.reset();
+
+  ecsify::TraceReader reader{TracePath()};
+  std::vector<ecsify::TraceOp> ops;
+  ecsify::TraceRecord record;
+  while (reader.Next(record)) {
+    ops.push_back(record.op);
+  }
+  ASSERT_EQ(ops, (std::vector<ecsify::TraceOp>{
+                     ecsify::TraceOp::kAddEntity,
+                     ecsify::TraceOp::kAddComponent,
+                 }));
+  std::filesystem::remove(TracePath());
+}
+
+TEST(TraceTests, RecordsGetMany) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Position>()
+                   .Component<Health>()
+                   .RecordTrace(TracePath())
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 2; ++i) {
+    entities.push_back(world->Add());
+    world->Add<Position>(entities.back());
+    world->Add<Health>(entities.back());
+  }
+  world->GetMany<Position, Health>(entities);
+  world.reset();
+
+  ecsify::TraceReader reader{TracePath()};
+  std::vector<std::size_t> gets;
+  ecsify::TraceRecord record;
+  while (reader.Next(record)) {
+    if (record.op == ecsify::TraceOp::kGetComponent) {
+      gets.push_back(record.component);
+    }
+  }
+  ASSERT_EQ(gets, (std::vector<std::size_t>{1, 2, 1, 2}));
+  std::filesystem::remove(TracePath());
+}
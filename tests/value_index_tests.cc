@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "ecsify/component.h"
+#include "ecsify/entity.h"
+#include "ecsify/value_index.h"
+#include "ecsify/world_builder.h"
+
+namespace {
+
+struct PlayerId : ecsify::ComponentMixin<1> {
+  int value;
+};
+
+struct Team : ecsify::ComponentMixin<2> {
+  int value;
+};
+
+using PlayerIndex = ecsify::HashIndex<PlayerId, &PlayerId::value>;
+using TeamIndex = ecsify::GroupIndex<Team, &Team::value>;
+
+}  // namespace
+
+TEST(ValueIndexTests, HashIndexLookup) {
+  auto players = std::make_shared<PlayerIndex>();
+  auto world = ecsify::WorldBuilder{}
+                   .Component<PlayerId>()
+                   .Track<PlayerId>(players)
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 10; ++i) {
+    ecsify::Entity entity = world->Add();
+    world->Add<PlayerId>(entity);
+    world->Set(entity, PlayerId{.value = 100 + i});
+    entities.push_back(entity);
+  }
+  ASSERT_EQ(players->Size(), entities.size());
+  ASSERT_EQ(players->Find(103), entities[3]);
+  ASSERT_EQ(players->Find(0), ecsify::Entity{});
+
+  world->Set(entities[3], PlayerId{.value = 7});
+  ASSERT_EQ(players->Find(103), ecsify::Entity{});
+  ASSERT_EQ(players->Find(7), entities[3]);
+
+  world->Remove<PlayerId>(entities[3]);
+  world->Remove(entities[4]);
+  ASSERT_EQ(players->Find(7), ecsify::Entity{});
+  ASSERT_EQ(players->Find(104), ecsify::Entity{});
+  ASSERT_EQ(players->Size(), entities.size() - 2);
+}
+
+TEST(ValueIndexTests, HashIndexSharedKeys) {
+  auto players = std::make_shared<PlayerIndex>();
+  auto world = ecsify::WorldBuilder{}
+                   .Component<PlayerId>()
+                   .Track<PlayerId>(players)
+                   .Build();
+  ecsify::Entity first = world->Add();
+  world->Add<PlayerId>(first);
+  world->Set(first, PlayerId{.value = 5});
+  ecsify::Entity second = world->Add();
+  world->Add<PlayerId>(second);
+  world->Set(second, PlayerId{.value = 5});
+  ASSERT_EQ(players->Size(), 1);
+  ASSERT_EQ(players->Find(5), second);
+
+  world->Remove(second);
+  ASSERT_EQ(players->Find(5), first);
+  world->Set(first, PlayerId{.value = 6});
+  ASSERT_EQ(players->Find(5), ecsify::Entity{});
+  ASSERT_EQ(players->Size(), 1);
+}
+
+TEST(ValueIndexTests, GroupIndexLookup) {
+  auto teams = std::make_shared<TeamIndex>();
+  auto world = ecsify::WorldBuilder{}
+                   .Component<PlayerId>()
+                   .Component<Team>()
+                   .Track<Team>(teams)
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 30; ++i) {
+    ecsify::Entity entity = world->Add();
+    world->Add<Team>(entity);
+    world->Set(entity, Team{.value = i % 3});
+    entities.push_back(entity);
+  }
+  ASSERT_EQ(teams->NumGroups(), 3);
+  ASSERT_EQ(teams->Find(1).size(), 10);
+  for (ecsify::Entity entity : teams->Find(1)) {
+    ASSERT_EQ(world->Get<Team>(entity).value, 1);
+  }
+
+  // Tracked in-place modification moves the entity to the other group.
+  world->Get<Team>(entities[1]).value = 2;
+  world->Modified<Team>(entities[1]);
+  ASSERT_EQ(teams->Find(1).size(), 9);
+  ASSERT_EQ(teams->Find(2).size(), 11);
+  ASSERT_NE(std::ranges::find(teams->Find(2), entities[1]),
+            teams->Find(2).end());
+
+  world->RemoveAll<Team>();
+  ASSERT_EQ(teams->NumGroups(), 0);
+  ASSERT_TRUE(teams->Find(2).empty());
+}
@@ -1,12 +1,35 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <filesystem>
+#include <ranges>
 #include <set>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "ecsify/component.h"
 #include "ecsify/entity.h"
+#include "ecsify/internal/mapped_file.h"
+#include "ecsify/world.h"
 #include "ecsify/world_builder.h"
 
+namespace {
+
+// Adds an entity with the component set to the value.
+template <class T>
+ecsify::Entity AddWith(ecsify::World &world, const T &value) {
+  ecsify::Entity entity = world.Add();
+  world.Add<T>(entity);
+  world.Get<T>(entity) = value;
+  return entity;
+}
+
+}  // namespace
+
 TEST(WorldTests, AddedEntitiesAreAlive) {
   auto world = ecsify::WorldBuilder{}.Build();
   ecsify::Entity entt1 = world->Add();
@@ -51,6 +74,26 @@ TEST(WorldTests, AddedRemovedEntitiesLiveness) {
 
 struct Dummy : ecsify::ComponentMixin<1> {};
 
+TEST(WorldTests, ReservedEntitiesAreAliveAfterFlush) {
+  auto world = ecsify::WorldBuilder{}.Build();
+  ecsify::Entity entt1 = world->ReserveEntity();
+  std::vector<ecsify::Entity> reserved = world->ReserveEntities(2);
+  ecsify::Entity entt2 = world->Add();
+  ASSERT_FALSE(world->Alive(entt1));
+  ASSERT_TRUE(world->Alive(entt2));
+  world->Flush();
+  ASSERT_TRUE(world->Alive(entt1));
+  ASSERT_TRUE(world->Alive(reserved[0]));
+  ASSERT_TRUE(world->Alive(reserved[1]));
+  std::set<std::int64_t> queried_entity_ids;
+  for (auto [entt] : world->Query<ecsify::Entity>()) {
+    queried_entity_ids.insert(entt.id());
+  }
+  ASSERT_EQ(queried_entity_ids,
+            (std::set<std::int64_t>{entt1.id(), reserved[0].id(),
+                                    reserved[1].id(), entt2.id()}));
+}
+
 TEST(WorldTests, EntitiesOwnAddedComponents) {
   auto world = ecsify::WorldBuilder{}.Component<Dummy>().Build();
   ecsify::Entity entt1 = world->Add();
@@ -133,3 +176,529 @@ TEST(WorldTests, Queries) {
   ASSERT_TRUE(queried_entity_ids.empty());
   ASSERT_TRUE(queried_int_vals.empty());
 }
+
+struct Flag : ecsify::ComponentMixin<2> {};
+
+TEST(WorldTests, QueriesSkipMigratedRows) {
+  auto world =
+      ecsify::WorldBuilder{}.Component<Int>().Component<Flag>().Build();
+  ecsify::Entity entt1 = world->Add();
+  world->Add<Int>(entt1);
+  world->Get<Int>(entt1).val = 1;
+  ecsify::Entity entt2 = world->Add();
+  world->Add<Int>(entt2);
+  world->Get<Int>(entt2).val = 2;
+  world->Add<Flag>(entt2);
+  world->Remove<Int>(entt1);
+
+  std::set<std::int64_t> queried_entity_ids;
+  for (auto [entt, val] : world->Query<ecsify::Entity, Int>()) {
+    ASSERT_EQ(entt.id(), entt2.id());
+    ASSERT_EQ(val.val, 2);
+    queried_entity_ids.insert(entt.id());
+  }
+  ASSERT_EQ(queried_entity_ids.size(), 1);
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity>()), 2);
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity, Flag>()), 1);
+}
+
+TEST(WorldTests, RemoveAllMatching) {
+  auto world =
+      ecsify::WorldBuilder{}.Component<Int>().Component<Flag>().Build();
+  std::set<std::int64_t> flagged_ids;
+  std::vector<ecsify::Entity> survivors;
+  for (int i = 0; i < 200; ++i) {
+    ecsify::Entity entt = world->Add();
+    world->Add<Int>(entt);
+    world->Get<Int>(entt).val = i;
+    if (i % 3 == 0) {
+      world->Add<Flag>(entt);
+      flagged_ids.insert(entt.id());
+    } else {
+      survivors.push_back(entt);
+    }
+  }
+
+  world->RemoveAll<Flag>();
+  for (ecsify::Entity entt : survivors) {
+    ASSERT_TRUE(world->Alive(entt));
+    ASSERT_EQ(world->Get<Int>(entt).val % 3 != 0, true);
+  }
+  for (auto [entt, val] : world->Query<ecsify::Entity, Int>()) {
+    ASSERT_FALSE(flagged_ids.contains(entt.id()));
+    ASSERT_EQ(world->Get<Int>(entt).val, val.val);
+  }
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity>()),
+            survivors.size());
+  ASSERT_EQ(std::ranges::distance(world->Query<Flag>()), 0);
+
+  // Storage of the removed archetype can be reused.
+  ecsify::Entity entt = world->Add();
+  world->Add<Flag>(entt);
+  ASSERT_TRUE(world->Has<Flag>(entt));
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity, Flag>()), 1);
+
+  world->RemoveAll<>();
+  ASSERT_FALSE(world->Alive(entt));
+  for (ecsify::Entity survivor : survivors) {
+    ASSERT_FALSE(world->Alive(survivor));
+  }
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity>()), 0);
+}
+
+TEST(WorldTests, SortedStorage) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Int>()
+                   .Component<Flag>()
+                   .SortBy<Int>([](const Int &component) {
+                     return component.val;
+                   })
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 300; ++i) {
+    ecsify::Entity entt = world->Add();
+    world->Add<Int>(entt);
+    world->Set(entt, Int{.val = (i * 37) % 101});
+    if (i % 4 == 0) {
+      world->Add<Flag>(entt);
+    }
+    entities.push_back(entt);
+  }
+  world->Remove(entities[5]);
+  world->Set(entities[6], Int{.val = -1});
+  world->Sort();
+
+  // Both archetypes holding Int are ordered.
+  for (auto [entt, val] : world->Query<ecsify::Entity, Int>()) {
+    ASSERT_EQ(world->Get<Int>(entt).val, val.val);
+  }
+  int prev = -1;
+  for (auto [entt, val, flag] : world->Query<ecsify::Entity, Int, Flag>()) {
+    ASSERT_LE(prev, val.val);
+    prev = val.val;
+  }
+  std::vector<int> values;
+  for (auto [val] : world->Query<Int>()) {
+    values.push_back(val.val);
+  }
+  ASSERT_EQ(values.size(), entities.size() - 1);
+  auto unflagged_begin = std::ranges::is_sorted_until(values);
+  ASSERT_TRUE(std::ranges::is_sorted(unflagged_begin, values.end()));
+  ASSERT_EQ(std::ranges::min(values), -1);
+}
+
+TEST(WorldTests, InstantiatePrefab) {
+  auto world =
+      ecsify::WorldBuilder{}.Component<Int>().Component<Flag>().Build();
+  ecsify::Entity prefab = world->AddPrefab();
+  world->Add<Int>(prefab);
+  world->Get<Int>(prefab).val = 42;
+  world->Add<Flag>(prefab);
+  ecsify::Entity other = AddWith(*world, Int{});
+  world->Add<Flag>(other);
+  world->Remove(other);
+  std::vector<ecsify::Entity> entities = world->Instantiate(prefab, 100);
+  ASSERT_EQ(entities.size(), 100);
+  std::set<std::int64_t> ids;
+  for (ecsify::Entity entity : entities) {
+    ASSERT_TRUE(world->Alive(entity));
+    ASSERT_EQ(world->Get<Int>(entity).val, 42);
+    ASSERT_TRUE(world->Has<Flag>(entity));
+    ids.insert(entity.id());
+  }
+  std::size_t num_queried = 0;
+  for (auto [entt, value] : world->Query<ecsify::Entity, Int>()) {
+    ASSERT_TRUE(ids.contains(entt.id()));
+    ASSERT_EQ(value.val, 42);
+    ++num_queried;
+  }
+  ASSERT_EQ(num_queried, 100);
+  world->Remove<Flag>(entities[0]);
+  ASSERT_EQ(world->Get<Int>(entities[0]).val, 42);
+  world->RemoveAll<Int>();
+  ASSERT_TRUE(world->Alive(prefab));
+  ASSERT_EQ(world->Instantiate(prefab, 1).size(), 1);
+}
+
+struct Clock {
+  int ticks;
+};
+
+struct Config {
+  int step;
+};
+
+TEST(WorldTests, Resources) {
+  auto world = ecsify::WorldBuilder{}
+                   .Resource<Clock>()
+                   .Resource(Config{.step = 2})
+                   .System([](ecsify::World &world) {
+                     world.Resource<Clock>().ticks +=
+                         world.Resource<const Config>().step;
+                   })
+                   .Build();
+  world->Update();
+  world->Update();
+  ASSERT_EQ(world->Resource<Clock>().ticks, 4);
+  const ecsify::World &const_world = *world;
+  ASSERT_EQ(const_world.Resource<Config>().step, 2);
+  auto other = ecsify::WorldBuilder{}.Resource<Clock>().Build();
+  ASSERT_EQ(other->Resource<Clock>().ticks, 0);
+}
+
+TEST(WorldTests, FileBackedComponents) {
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "ecsify_world_test";
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Int>()
+                   .Component<Flag>()
+                   .PageToFiles(directory)
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 300; ++i) {
+    ecsify::Entity entt = world->Add();
+    world->Add<Int>(entt);
+    world->Get<Int>(entt).val = i;
+    if (i % 2 == 0) {
+      world->Add<Flag>(entt);
+    }
+    entities.push_back(entt);
+  }
+  world->Sync();
+  for (int i = 0; i < 300; ++i) {
+    ASSERT_EQ(world->Get<Int>(entities[i]).val, i);
+  }
+  ASSERT_EQ(std::ranges::distance(world->Query<Int, Flag>()), 150);
+  ASSERT_TRUE(std::filesystem::exists(directory / "1"));
+  world.reset();
+  std::filesystem::remove_all(directory);
+}
+
+TEST(WorldTests, FileBackedWorldsAreRestored) {
+  if (!ecsify::internal::kMappedFiles) {
+    GTEST_SKIP() << "Files can't be mapped";
+  }
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "ecsify_restore_test";
+  std::filesystem::remove_all(directory);
+  auto build = [&] {
+    return ecsify::WorldBuilder{}
+        .Component<Int>()
+        .Component<Flag>()
+        .PageToFiles(directory)
+        .Build();
+  };
+  std::vector<ecsify::Entity> entities;
+  {
+    auto world = build();
+    for (int i = 0; i < 300; ++i) {
+      entities.push_back(AddWith(*world, Int{.val = i}));
+      if (i % 3 == 0) {
+        world->Add<Flag>(entities.back());
+      }
+    }
+    world->Remove(entities[10]);
+    world->SetParent(entities[2], entities[1]);
+    world->Sync();
+  }
+  {
+    auto world = build();
+    ASSERT_FALSE(world->Alive(entities[10]));
+    for (int i = 0; i < 300; ++i) {
+      if (i == 10) {
+        continue;
+      }
+      ASSERT_TRUE(world->Alive(entities[i]));
+      ASSERT_EQ(world->Get<Int>(entities[i]).val, i);
+      ASSERT_EQ(world->Has<Flag>(entities[i]), i % 3 == 0);
+    }
+    ASSERT_EQ(world->Parent(entities[2]), entities[1]);
+    ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 299);
+    ASSERT_EQ(std::ranges::distance(world->Query<Int, Flag>()), 100);
+    // The removed entity's handle is reused with a new id.
+    ecsify::Entity added = world->Add();
+    ASSERT_EQ(added.handle(), entities[10].handle());
+    ASSERT_NE(added, entities[10]);
+    world->Add<Flag>(added);
+    // Destroying the world syncs it.
+  }
+  auto world = build();
+  ASSERT_EQ(std::ranges::distance(world->Query<Flag>()), 101);
+  world.reset();
+  std::filesystem::remove_all(directory);
+}
+
+TEST(WorldTests, OutOfSyncFilesAreRejected) {
+  if (!ecsify::internal::kMappedFiles) {
+    GTEST_SKIP() << "Files can't be mapped";
+  }
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "ecsify_out_of_sync_test";
+  std::filesystem::remove_all(directory);
+  auto build = [&] {
+    return ecsify::WorldBuilder{}
+        .Component<Int>()
+        .PageToFiles(directory)
+        .Build();
+  };
+  std::filesystem::path state = directory / "world.state";
+  std::filesystem::path stale = directory / "stale.state";
+  {
+    auto world = build();
+    AddWith(*world, Int{.val = 1});
+    world->Sync();
+    std::filesystem::copy_file(state, stale);
+    AddWith(*world, Int{.val = 2});
+  }
+  std::filesystem::rename(stale, state);
+  ASSERT_THROW(build(), std::runtime_error);
+  std::filesystem::remove_all(directory);
+}
+
+struct Stats : ecsify::ComponentMixin<1> {
+  int health;
+};
+
+struct StatsHistory : ecsify::ComponentMixin<2> {
+  std::array<int, 64> history;
+};
+
+TEST(WorldTests, SplitComponentsMoveTogether) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Stats>()
+                   .Component<StatsHistory>()
+                   .Split<Stats, StatsHistory>()
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 100; ++i) {
+    ecsify::Entity entt = AddWith(*world, Stats{.health = i});
+    world->Get<StatsHistory>(entt).history[0] = -i;
+    entities.push_back(entt);
+  }
+  ASSERT_EQ(std::ranges::distance(world->Query<Stats>()), 100);
+  ASSERT_EQ(std::ranges::distance(world->Query<StatsHistory>()), 100);
+  for (auto [stats, history] : world->Query<Stats, StatsHistory>()) {
+    ASSERT_EQ(stats.health, -history.history[0]);
+  }
+  for (int i = 0; i < 100; i += 2) {
+    world->Remove<StatsHistory>(entities[i]);
+  }
+  ASSERT_FALSE(world->Has<Stats>(entities[0]));
+  ASSERT_TRUE(world->Has<Stats>(entities[1]));
+  ASSERT_EQ(world->Get<Stats>(entities[1]).health, 1);
+  ASSERT_EQ(world->Get<StatsHistory>(entities[1]).history[0], -1);
+  ASSERT_EQ(std::ranges::distance(world->Query<Stats>()), 50);
+  ASSERT_EQ(std::ranges::distance(world->Query<StatsHistory>()), 50);
+}
+
+struct Marker : ecsify::ComponentMixin<3> {};
+
+TEST(WorldTests, AddToAndRemoveFromAllMatching) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Int>()
+                   .Component<Flag>()
+                   .Component<Marker>()
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 300; ++i) {
+    ecsify::Entity entt = AddWith(*world, Int{.val = i});
+    if (i % 3 == 0) {
+      world->Add<Marker>(entt);
+    }
+    entities.push_back(entt);
+  }
+  // Leaves a gap in one archetype, so its rows can't be relabeled.
+  world->Remove(entities[3]);
+  world->AddToAll<Flag, Int>();
+  ASSERT_EQ(std::ranges::distance(world->Query<Int, Flag>()), 299);
+  for (int i = 0; i < 300; ++i) {
+    if (i == 3) {
+      continue;
+    }
+    ASSERT_TRUE(world->Has<Flag>(entities[i]));
+    ASSERT_EQ(world->Get<Int>(entities[i]).val, i);
+  }
+  for (auto [entity, val] : world->Query<ecsify::Entity, Int>()) {
+    ASSERT_EQ(world->Get<Int>(entity).val, val.val);
+  }
+  world->RemoveFromAll<Flag, Marker>();
+  ASSERT_EQ(std::ranges::distance(world->Query<Flag>()), 200);
+  ASSERT_FALSE(world->Has<Flag>(entities[0]));
+  ASSERT_TRUE(world->Has<Marker>(entities[0]));
+  ASSERT_TRUE(world->Has<Flag>(entities[1]));
+  // Moves rows into a populated archetype.
+  world->Add<Flag>(entities[0]);
+  world->AddToAll<Flag, Marker>();
+  ASSERT_EQ(std::ranges::distance(world->Query<Flag>()), 299);
+  for (auto [entity, val, marker] :
+       world->Query<ecsify::Entity, Int, Marker>()) {
+    ASSERT_EQ(world->Get<Int>(entity).val, val.val);
+  }
+  world->RemoveFromAll<Int>();
+  ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 0);
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity>()), 299);
+}
+
+TEST(WorldTests, ForkAndRollback) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Int>()
+                   .Component<Flag>()
+                   .Rollback(2)
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 200; ++i) {
+    entities.push_back(AddWith(*world, Int{.val = i}));
+  }
+  world->SetParent(entities[1], entities[0]);
+  std::uint64_t first = world->Fork();
+  for (auto [val] : world->Query<Int>()) {
+    val.val *= 2;
+  }
+  world->Remove(entities[5]);
+  world->Add<Flag>(entities[6]);
+  ecsify::Entity added = world->Add();
+  world->RemoveParent(entities[1]);
+  std::uint64_t second = world->Fork();
+  world->RemoveAll<Int>();
+  ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 0);
+
+  world->Rollback(second);
+  ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 199);
+  ASSERT_EQ(world->Get<Int>(entities[7]).val, 14);
+  ASSERT_TRUE(world->Has<Flag>(entities[6]));
+  ASSERT_TRUE(world->Alive(added));
+
+  world->Rollback(first);
+  ASSERT_FALSE(world->Alive(added));
+  ASSERT_TRUE(world->Alive(entities[5]));
+  ASSERT_FALSE(world->Has<Flag>(entities[6]));
+  ASSERT_EQ(world->Parent(entities[1]), entities[0]);
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_EQ(world->Get<Int>(entities[i]).val, i);
+  }
+  // The first fork is kept, so the world can be re-simulated again.
+  world->Remove(entities[0]);
+  world->Rollback(first);
+  ASSERT_TRUE(world->Alive(entities[0]));
+  ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 200);
+  // Replaying the calls gives the same entities.
+  world->Remove(entities[5]);
+  ASSERT_EQ(world->Add(), added);
+}
+
+TEST(WorldTests, DisabledComponentsAreSkippedByQueries) {
+  auto world =
+      ecsify::WorldBuilder{}.Component<Int>().Component<Flag>().Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 100; ++i) {
+    entities.push_back(AddWith(*world, Int{.val = i}));
+  }
+  for (int i = 0; i < 100; i += 10) {
+    world->Disable<Int>(entities[i]);
+  }
+  ASSERT_FALSE(world->Enabled<Int>(entities[10]));
+  ASSERT_TRUE(world->Has<Int>(entities[10]));
+  ASSERT_EQ(world->Get<Int>(entities[10]).val, 10);
+  ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 90);
+  ASSERT_EQ(std::ranges::distance(world->Query<ecsify::Entity>()), 100);
+  for (auto [val] : world->Query<const Int>()) {
+    ASSERT_NE(val.val % 10, 0);
+  }
+
+  // The bit follows the row to another archetype.
+  world->Add<Flag>(entities[20]);
+  world->Add<Flag>(entities[21]);
+  ASSERT_FALSE(world->Enabled<Int>(entities[20]));
+  ASSERT_EQ(std::ranges::distance(world->Query<Int, Flag>()), 1);
+  world->Enable<Int>(entities[20]);
+  ASSERT_EQ(std::ranges::distance(world->Query<Int, Flag>()), 2);
+  ASSERT_EQ(std::ranges::distance(world->Query<Int>()), 91);
+
+  // Removing the component drops the bit.
+  world->Remove<Int>(entities[30]);
+  world->Add<Int>(entities[30]);
+  ASSERT_TRUE(world->Enabled<Int>(entities[30]));
+}
+
+struct Position : ecsify::ComponentMixin<3> {
+  float x, y;
+};
+
+TEST(WorldTests, GetSeveralComponents) {
+  auto world = ecsify::WorldBuilder{}
+                   .Component<Int>()
+                   .Component<Flag>()
+                   .Component<Position>()
+                   .Build();
+  std::vector<ecsify::Entity> entities;
+  for (int i = 0; i < 300; ++i) {
+    ecsify::Entity entt = AddWith(*world, Int{.val = i});
+    world->Add<Position>(entt);
+    if (i % 3 == 0) {
+      world->Add<Flag>(entt);
+    }
+    entities.push_back(entt);
+  }
+  auto [val, position] = world->Get<Int, Position>(entities[7]);
+  ASSERT_EQ(val.val, 7);
+  position.x = 7;
+  ASSERT_EQ(world->Get<Position>(entities[7]).x, 7);
+
+  // References resolved in bulk come back in the order asked for.
+  std::vector<ecsify::Entity> targets = {entities[299], entities[0],
+                                         entities[150], entities[0],
+                                         entities[151]};
+  for (int i = 1; i < 300; i += 7) {
+    targets.push_back(entities[i]);
+  }
+  auto found = world->GetMany<const Int, Position>(targets);
+  ASSERT_EQ(found.size(), targets.size());
+  for (std::size_t idx = 0; idx < targets.size(); ++idx) {
+    auto [target_val, target_position] = found[idx];
+    ASSERT_EQ(&target_val, &world->Get<Int>(targets[idx]));
+    ASSERT_EQ(&target_position, &world->Get<Position>(targets[idx]));
+  }
+  ASSERT_EQ(std::get<0>(found[2]).val, 150);
+}
+
+template <std::size_t kId>
+struct Tag : ecsify::ComponentMixin<kId> {
+  std::size_t value;
+};
+
+template <std::size_t... kIds>
+auto BuildTagWorld(std::index_sequence<kIds...>) {
+  return ecsify::WorldBuilder<Tag<kIds + 1>...>{}.Build();
+}
+
+TEST(WorldTests, ManyComponentTypes) {
+  constexpr std::size_t kNumTypes = 70;
+  auto world = BuildTagWorld(std::make_index_sequence<kNumTypes>{});
+  std::vector<ecsify::Entity> entities;
+  for (std::size_t idx = 0; idx < 100; ++idx) {
+    ecsify::Entity entity = world->Add();
+    world->Add<Tag<1>>(entity);
+    world->Add<Tag<kNumTypes>>(entity);
+    world->Get<Tag<kNumTypes>>(entity).value = idx;
+    if (idx % 2 == 0) {
+      world->Add<Tag<40>>(entity);
+    }
+    entities.push_back(entity);
+  }
+  ASSERT_TRUE(world->Has<Tag<kNumTypes>>(entities[0]));
+  ASSERT_TRUE(world->Has<Tag<40>>(entities[0]));
+  ASSERT_FALSE(world->Has<Tag<40>>(entities[1]));
+  ASSERT_FALSE(world->Has<Tag<33>>(entities[0]));
+  ASSERT_EQ(std::ranges::distance(world->Query<Tag<40>, Tag<kNumTypes>>()),
+            50);
+  for (ecsify::Entity entity : entities) {
+    world->Remove<Tag<1>>(entity);
+  }
+  std::set<std::size_t> values;
+  for (auto [tag, last] : world->Query<Tag<40>, Tag<kNumTypes>>()) {
+    values.insert(last.value);
+  }
+  ASSERT_EQ(values.size(), 50);
+  ASSERT_EQ(*values.rbegin(), 98);
+  ASSERT_EQ(std::ranges::distance(world->Query<Tag<1>>()), 0);
+}